@@ -0,0 +1,210 @@
+#include "BoundaryMask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Relics/Utils/Utils.h"
+
+std::unique_ptr<BoundaryMask> BoundaryMask::make(const BoundaryShape shape, const int size, const unsigned int seed)
+{
+	RandomGenerator rg(seed);
+	const float center = static_cast<float>(size) / 2.f;
+	const auto random = [&rg](const float min, const float max)
+	{
+		return min + (max - min) * static_cast<float>(rg.getRandom(0, 1000)) / 1000.f;
+	};
+
+	switch (shape)
+	{
+	case BoundaryShape::Island:
+	{
+		//a disc whose shore swells and bays with a few waves around it
+		const float radius = center * 0.8f;
+		const float phases[3] = {random(0.f, 6.3f), random(0.f, 6.3f), random(0.f, 6.3f)};
+		const float amplitudes[3] = {random(0.06f, 0.14f), random(0.04f, 0.09f), random(0.02f, 0.05f)};
+		return std::make_unique<SdfMask>([=](const float r, const float c)
+		{
+			const float dr = r - center;
+			const float dc = c - center;
+			const float angle = std::atan2(dr, dc);
+			const float shore = radius * (1.f + amplitudes[0] * std::sin(3.f * angle + phases[0])
+				+ amplitudes[1] * std::sin(5.f * angle + phases[1]) + amplitudes[2] * std::sin(9.f * angle + phases[2]));
+			return std::sqrt(dr * dr + dc * dc) - shore;
+		}, 2.f);
+	}
+	case BoundaryShape::Cave:
+	{
+		//a ring of corners whose distance from the middle wanders, smoothed a little so the walls stay passable
+		const int count = 48;
+		std::vector<float> radii(count);
+		float walk = random(0.75f, 0.95f);
+		for (float& radius : radii)
+		{
+			walk = std::clamp(walk + random(-0.15f, 0.15f), 0.55f, 1.f);
+			radius = walk;
+		}
+		std::vector<std::pair<float, float>> corners;
+		for (int i = 0; i < count; i++)
+		{
+			const float radius = center * (radii[(i + count - 1) % count] + 2.f * radii[i] + radii[(i + 1) % count]) / 4.f;
+			const float angle = 2.f * std::numbers::pi_v<float> * static_cast<float>(i) / count;
+			corners.emplace_back(center + radius * std::sin(angle), center + radius * std::cos(angle));
+		}
+		return std::make_unique<PolygonMask>(std::move(corners));
+	}
+	default:
+		return std::make_unique<CircleMask>();
+	}
+}
+
+bool CircleMask::isOutside(const int r, const int c, const int size)
+{
+	//the same float arithmetic the cell by cell loop used, so the disc keeps every one of its cells
+	const auto center = static_cast<float>(size) / 2.f;
+	const auto i = static_cast<float>(r);
+	const auto j = static_cast<float>(c);
+	const auto d = static_cast<float>(std::sqrt(
+		std::pow(center - (i > center ? i : i + 1), 2) + center
+		+ std::pow(center - (j > center ? j : j + 1), 2) + center));
+	return d > center;
+}
+
+void CircleMask::getSpans(const int r, const int size, std::pmr::vector<MaskSpan>& spans) const
+{
+	//the open cells of a row are one run around the middle column, both of its ends are found by bisection
+	const int middle = std::clamp(static_cast<int>(std::ceil(static_cast<float>(size) / 2.f)) - 1, 0, size - 1);
+	if (size <= 0 || isOutside(r, middle, size))
+	{
+		return;
+	}
+	int low = 0;
+	int high = middle;
+	while (low < high)
+	{
+		const int mid = (low + high) / 2;
+		if (isOutside(r, mid, size))
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	const int first = low;
+	low = middle;
+	high = size - 1;
+	while (low < high)
+	{
+		const int mid = (low + high + 1) / 2;
+		if (isOutside(r, mid, size))
+		{
+			high = mid - 1;
+		}
+		else
+		{
+			low = mid;
+		}
+	}
+	spans.emplace_back(first, low + 1);
+}
+
+PolygonMask::PolygonMask(std::vector<std::pair<float, float>> corners)
+	: corners(std::move(corners))
+{
+}
+
+void PolygonMask::getSpans(const int r, const int size, std::pmr::vector<MaskSpan>& spans) const
+{
+	//where the edges cross the row's centre line, an edge counts on its lower end but not its upper one
+	const float y = static_cast<float>(r) + 0.5f;
+	std::pmr::vector<float> crossings(spans.get_allocator());
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		const auto& a = corners[i];
+		const auto& b = corners[(i + 1) % corners.size()];
+		if ((a.first > y) != (b.first > y))
+		{
+			crossings.push_back(a.second + (y - a.first) * (b.second - a.second) / (b.first - a.first));
+		}
+	}
+	std::sort(crossings.begin(), crossings.end());
+	for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+	{
+		//the cells whose centres lie between a pair of crossings
+		const int from = std::max(0, static_cast<int>(std::ceil(crossings[i] - 0.5f)));
+		const int to = std::min(size, static_cast<int>(std::ceil(crossings[i + 1] - 0.5f)));
+		if (from < to)
+		{
+			spans.emplace_back(from, to);
+		}
+	}
+}
+
+SdfMask::SdfMask(std::function<float(float r, float c)> distance, const float lipschitz)
+	: distance(std::move(distance)), lipschitz(std::max(lipschitz, 1e-3f))
+{
+}
+
+void SdfMask::getSpans(const int r, const int size, std::pmr::vector<MaskSpan>& spans) const
+{
+	const float y = static_cast<float>(r) + 0.5f;
+	int start = -1;
+	for (int c = 0; c < size;)
+	{
+		const float d = distance(y, static_cast<float>(c) + 0.5f);
+		//no cell closer than |d| / lipschitz can be on the other side of the outline
+		const int run = std::max(1, static_cast<int>(std::fabs(d) / lipschitz));
+		if (d < 0.f && start < 0)
+		{
+			start = c;
+		}
+		else if (d >= 0.f && start >= 0)
+		{
+			spans.emplace_back(start, c);
+			start = -1;
+		}
+		c = std::min(size, c + run);
+	}
+	if (start >= 0)
+	{
+		spans.emplace_back(start, size);
+	}
+}
+
+ImageMask::ImageMask(const int width, const int height, std::vector<uint8_t> pixels, const uint8_t threshold)
+	: width(width), height(height), pixels(std::move(pixels)), threshold(threshold)
+{
+}
+
+void ImageMask::getSpans(const int r, const int size, std::pmr::vector<MaskSpan>& spans) const
+{
+	if (width <= 0 || height <= 0 || pixels.size() < static_cast<size_t>(width) * height)
+	{
+		return;
+	}
+	//nearest pixel, so runs of pixels turn into runs of columns without looking at every cell
+	const int y = std::min(height - 1, static_cast<int>(static_cast<int64_t>(r) * height / size));
+	const uint8_t* row = pixels.data() + static_cast<size_t>(y) * width;
+	for (int x = 0; x < width;)
+	{
+		if (row[x] < threshold)
+		{
+			x++;
+			continue;
+		}
+		const int first = x;
+		while (x < width && row[x] >= threshold)
+		{
+			x++;
+		}
+		//pixel x covers the columns from ceil(x * size / width) up to the next pixel's
+		const auto from = static_cast<int>((static_cast<int64_t>(first) * size + width - 1) / width);
+		const auto to = static_cast<int>((static_cast<int64_t>(x) * size + width - 1) / width);
+		if (from < to)
+		{
+			spans.emplace_back(from, to);
+		}
+	}
+}
@@ -0,0 +1,150 @@
+#include "CorridorRouter.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+CorridorRouter::CorridorRouter(const int maxExpansions)
+	: size(0), maxExpansions(maxExpansions), stamp(0)
+{
+}
+
+void CorridorRouter::reset(const TwoDArray& grid, const RoomIdLayer& roomIds)
+{
+	size = roomIds.getSize();
+	const size_t cells = static_cast<size_t>(size) * size;
+	cost.resize(cells);
+	for (int r = 0; r < size; r++)
+	{
+		for (int c = 0; c < size; c++)
+		{
+			const bool open = roomIds.get(r, c) < 0 && grid.get(r, c, 'X') != 'X';
+			cost[r * size + c] = open ? FREE : BLOCKED;
+		}
+	}
+	//buffers only grow, a smaller floor reuses what a larger one allocated
+	if (g.size() < cells)
+	{
+		g.resize(cells);
+		parent.resize(cells);
+		seen.assign(cells, 0);
+		closed.assign(cells, 0);
+		stamp = 0;
+	}
+}
+
+bool CorridorRouter::search(const int target, CellList& path)
+{
+	if (++stamp == 0)
+	{
+		std::fill(seen.begin(), seen.end(), 0);
+		std::fill(closed.begin(), closed.end(), 0);
+		stamp = 1;
+	}
+	const int tr = target / size;
+	const int tc = target % size;
+	const auto later = [](const Node& a, const Node& b)
+	{
+		return a.f > b.f;
+	};
+	const auto heuristic = [&](const int cell)
+	{
+		return static_cast<uint32_t>(std::abs(cell / size - tr) + std::abs(cell % size - tc)) * SHARED;
+	};
+
+	open.clear();
+	for (const int source : sources)
+	{
+		seen[source] = stamp;
+		g[source] = 0;
+		parent[source] = -1;
+		open.push_back({heuristic(source), source});
+	}
+	std::make_heap(open.begin(), open.end(), later);
+
+	int expansions = 0;
+	while (!open.empty() && expansions < maxExpansions)
+	{
+		std::pop_heap(open.begin(), open.end(), later);
+		const int cell = open.back().cell;
+		open.pop_back();
+		if (closed[cell] == stamp)
+		{
+			continue;
+		}
+		closed[cell] = stamp;
+		expansions++;
+
+		if (cell == target)
+		{
+			path.clear();
+			for (int step = cell; step >= 0; step = parent[step])
+			{
+				path.emplace_back(step / size, step % size);
+			}
+			std::reverse(path.begin(), path.end());
+			return true;
+		}
+
+		const int r = cell / size;
+		const int c = cell % size;
+		const int neighbours[4] = {
+			r > 0 ? cell - size : -1, r + 1 < size ? cell + size : -1, c > 0 ? cell - 1 : -1, c + 1 < size ? cell + 1 : -1
+		};
+		for (const int next : neighbours)
+		{
+			//the target door is a room cell like any other wall, so it is let in by name
+			if (next < 0 || closed[next] == stamp || (cost[next] == BLOCKED && next != target))
+			{
+				continue;
+			}
+			const uint32_t step = g[cell] + (next == target ? SHARED : cost[next]);
+			if (seen[next] != stamp || step < g[next])
+			{
+				seen[next] = stamp;
+				g[next] = step;
+				parent[next] = cell;
+				open.push_back({step + heuristic(next), next});
+				std::push_heap(open.begin(), open.end(), later);
+			}
+		}
+	}
+	return false;
+}
+
+int CorridorRouter::routeAll(const RoomGraph& graph, CorridorList& out)
+{
+	out.clear();
+	if (!size)
+	{
+		return 0;
+	}
+	const std::vector<DoorCell>& doors = graph.getDoors();
+	const std::vector<RoomLink>& links = graph.getLinks();
+	int failed = 0;
+	for (size_t l = 0; l < links.size(); l++)
+	{
+		const RoomLink& link = links[l];
+		sources.clear();
+		for (const DoorCell* door = graph.doorsBegin(link.a); door != graph.doorsEnd(link.a); ++door)
+		{
+			sources.push_back(door->r * size + door->c);
+		}
+		const DoorCell& goal = doors[link.doorB];
+
+		Corridor corridor{static_cast<int>(l), CellList(out.get_allocator())};
+		unless(search(goal.r * size + goal.c, corridor.cells))
+		{
+			failed++;
+			continue;
+		}
+		for (const auto& [r, c] : corridor.cells)
+		{
+			if (cost[r * size + c] != BLOCKED)
+			{
+				cost[r * size + c] = SHARED;
+			}
+		}
+		out.push_back(std::move(corridor));
+	}
+	return failed;
+}
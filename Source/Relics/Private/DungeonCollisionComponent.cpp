@@ -0,0 +1,62 @@
+#include "DungeonCollisionComponent.h"
+
+#include "PhysicsEngine/BodySetup.h"
+#include "Relics/Utils/Utils.h"
+
+UDungeonCollisionComponent::UDungeonCollisionComponent()
+	: bodySetup(nullptr), localBounds(ForceInit)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	SetGenerateOverlapEvents(false);
+	SetCanEverAffectNavigation(true);
+	bHiddenInGame = true;
+}
+
+void UDungeonCollisionComponent::setBoxes(const TArray<FBox>& boxes)
+{
+	unless(bodySetup)
+	{
+		bodySetup = NewObject<UBodySetup>(this, NAME_None, RF_Transient);
+		bodySetup->BodySetupGuid = FGuid::NewGuid();
+		bodySetup->bGenerateMirroredCollision = false;
+		bodySetup->bDoubleSidedGeometry = false;
+		//traces against the boxes themselves, there is no render mesh to fall back on
+		bodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+	}
+
+	bodySetup->AggGeom.BoxElems.Reset(boxes.Num());
+	localBounds.Init();
+	for (const FBox& box : boxes)
+	{
+		const FVector extent = box.GetSize();
+		FKBoxElem& element = bodySetup->AggGeom.BoxElems.Emplace_GetRef(extent.X, extent.Y, extent.Z);
+		element.Center = box.GetCenter();
+		localBounds += box;
+	}
+	bodySetup->InvalidatePhysicsData();
+	bodySetup->CreatePhysicsMeshes();
+
+	RecreatePhysicsState();
+	UpdateBounds();
+	MarkRenderStateDirty();
+}
+
+int32 UDungeonCollisionComponent::getBoxCount() const
+{
+	return bodySetup ? bodySetup->AggGeom.BoxElems.Num() : 0;
+}
+
+UBodySetup* UDungeonCollisionComponent::GetBodySetup()
+{
+	return bodySetup;
+}
+
+FBoxSphereBounds UDungeonCollisionComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	unless(localBounds.IsValid)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
+	}
+	return FBoxSphereBounds(localBounds.TransformBy(LocalToWorld));
+}
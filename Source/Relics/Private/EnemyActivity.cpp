@@ -0,0 +1,203 @@
+#include "EnemyActivity.h"
+
+#include <algorithm>
+
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Perception/AIPerceptionComponent.h"
+
+EnemyActivity::EnemyActivity(const RoomGraph& graph, const int maxHops)
+	: graph(graph), maxHops(maxHops), dormantCount(0)
+{
+}
+
+EnemyActivity::~EnemyActivity()
+{
+	wakeAll();
+}
+
+int EnemyActivity::roomAt(const FVector& location, const int fallback) const
+{
+	//the gap band between rooms belongs to no room, so whoever is crossing it keeps the room they left
+	const int room = graph.findRoom(location.X / 100.f, location.Y / 100.f);
+	return room >= 0 ? room : fallback;
+}
+
+void EnemyActivity::add(AActor* enemy)
+{
+	if (!IsValid(enemy))
+	{
+		return;
+	}
+	Sleeper& sleeper = enemies.emplace_back();
+	sleeper.actor = enemy;
+	sleeper.room = roomAt(enemy->GetActorLocation(), -1);
+	sleeper.dormant = false;
+}
+
+void EnemyActivity::pauseActor(AActor* actor, Sleeper& sleeper)
+{
+	if (actor->IsActorTickEnabled())
+	{
+		actor->SetActorTickEnabled(false);
+		sleeper.pausedActors.Add(actor);
+	}
+	//movement, skeletal mesh animation and anything else the blueprint added tick as components
+	for (UActorComponent* component : actor->GetComponents())
+	{
+		if (component && component->IsComponentTickEnabled())
+		{
+			component->SetComponentTickEnabled(false);
+			sleeper.pausedComponents.Add(component);
+		}
+	}
+}
+
+void EnemyActivity::sleep(Sleeper& sleeper)
+{
+	AActor* actor = sleeper.actor.Get();
+	if (!actor)
+	{
+		return;
+	}
+	pauseActor(actor, sleeper);
+
+	const APawn* pawn = Cast<APawn>(actor);
+	if (AAIController* controller = pawn ? Cast<AAIController>(pawn->GetController()) : nullptr)
+	{
+		pauseActor(controller, sleeper);
+		if (UBrainComponent* brain = controller->GetBrainComponent())
+		{
+			brain->PauseLogic(TEXT("Dormant"));
+		}
+		UAIPerceptionComponent* perception = controller->GetPerceptionComponent();
+		if (perception && perception->IsActive())
+		{
+			perception->Deactivate();
+			sleeper.deactivated.Add(perception);
+		}
+	}
+	sleeper.dormant = true;
+	dormantCount++;
+}
+
+void EnemyActivity::wake(Sleeper& sleeper)
+{
+	for (const TWeakObjectPtr<AActor>& paused : sleeper.pausedActors)
+	{
+		if (AActor* actor = paused.Get())
+		{
+			actor->SetActorTickEnabled(true);
+		}
+	}
+	for (const TWeakObjectPtr<UActorComponent>& paused : sleeper.pausedComponents)
+	{
+		if (UActorComponent* component = paused.Get())
+		{
+			component->SetComponentTickEnabled(true);
+		}
+	}
+	for (const TWeakObjectPtr<UActorComponent>& paused : sleeper.deactivated)
+	{
+		if (UActorComponent* component = paused.Get())
+		{
+			component->Activate();
+		}
+	}
+	sleeper.pausedActors.Reset();
+	sleeper.pausedComponents.Reset();
+	sleeper.deactivated.Reset();
+
+	const APawn* pawn = Cast<APawn>(sleeper.actor.Get());
+	if (const AAIController* controller = pawn ? Cast<AAIController>(pawn->GetController()) : nullptr)
+	{
+		if (UBrainComponent* brain = controller->GetBrainComponent())
+		{
+			brain->ResumeLogic(TEXT("Dormant"));
+		}
+	}
+	sleeper.dormant = false;
+	dormantCount--;
+}
+
+void EnemyActivity::update(const TArray<FVector>& players, TArray<AActor*>* leaving)
+{
+	//players joining or leaving shift the rest, so their rooms are found again from scratch
+	if (playerRooms.size() != static_cast<size_t>(players.Num()))
+	{
+		playerRooms.assign(players.Num(), -1);
+		hops.clear();
+	}
+	bool moved = hops.empty();
+	for (int32 i = 0; i < players.Num(); i++)
+	{
+		const int room = roomAt(players[i], playerRooms[i]);
+		moved |= room != playerRooms[i];
+		playerRooms[i] = room;
+	}
+	if (moved)
+	{
+		graph.hopsFrom(playerRooms, maxHops, hops);
+	}
+	if (std::ranges::none_of(playerRooms, [](const int room) { return room >= 0; }))
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < enemies.size();)
+	{
+		Sleeper& sleeper = enemies[i];
+		AActor* actor = sleeper.actor.Get();
+		if (!actor)
+		{
+			i++;
+			continue;
+		}
+		//sleeping enemies stay put, so only awake ones can have changed room
+		if (!sleeper.dormant)
+		{
+			sleeper.room = roomAt(actor->GetActorLocation(), sleeper.room);
+		}
+		const bool far = sleeper.room >= 0 && hops[sleeper.room] < 0;
+		if (far && leaving && !sleeper.dormant)
+		{
+			leaving->Add(actor);
+			enemies[i] = MoveTemp(enemies.back());
+			enemies.pop_back();
+			continue;
+		}
+		if (far && !sleeper.dormant)
+		{
+			sleep(sleeper);
+		}
+		else if (!far && sleeper.dormant)
+		{
+			wake(sleeper);
+		}
+		i++;
+	}
+}
+
+void EnemyActivity::wakeAll()
+{
+	for (Sleeper& sleeper : enemies)
+	{
+		if (sleeper.dormant)
+		{
+			wake(sleeper);
+		}
+	}
+	playerRooms.clear();
+	hops.clear();
+}
+
+int EnemyActivity::getDormantCount() const
+{
+	return dormantCount;
+}
+
+bool EnemyActivity::isNear(const int room) const
+{
+	return room >= 0 && room < static_cast<int>(hops.size()) && hops[room] >= 0;
+}
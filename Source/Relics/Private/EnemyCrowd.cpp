@@ -0,0 +1,205 @@
+#include "EnemyCrowd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+EnemyCrowd::EnemyCrowd(const RoomGraph& graph, const unsigned int seed, const float speed)
+	: graph(graph), rg(seed), speed(speed)
+{
+}
+
+bool EnemyCrowd::isFloor(const int room, const int r, const int c) const
+{
+	const RoomIdLayer& ids = graph.getRoomIds();
+	return ids.get(r, c) == room && ids.get(r - 1, c) == room && ids.get(r + 1, c) == room
+		&& ids.get(r, c - 1) == room && ids.get(r, c + 1) == room;
+}
+
+void EnemyCrowd::pickTarget(const int index)
+{
+	const RoomBounds& bounds = graph.getBounds(rooms[index]);
+	//odd shapes leave holes in the bounds, a few misses just keep the proxy standing for another wait
+	for (int attempt = 0; attempt < 4; attempt++)
+	{
+		const int r = rg.getRandom(bounds.row, bounds.row + bounds.height);
+		const int c = rg.getRandom(bounds.col, bounds.col + bounds.width);
+		if (isFloor(rooms[index], r, c))
+		{
+			targetRows[index] = r;
+			targetCols[index] = c;
+			return;
+		}
+	}
+	waits[index] = MAX_WAIT * static_cast<float>(rg.getRandom(1, 10)) / 10.f;
+}
+
+bool EnemyCrowd::nearestFloor(const int room, int& r, int& c) const
+{
+	const RoomBounds& bounds = graph.getBounds(room);
+	int best = -1;
+	for (int row = bounds.row; row <= bounds.row + bounds.height; row++)
+	{
+		for (int col = bounds.col; col <= bounds.col + bounds.width; col++)
+		{
+			const int distance = std::abs(row - r) + std::abs(col - c);
+			if ((best < 0 || distance < best) && isFloor(room, row, col))
+			{
+				best = distance;
+				r = row;
+				c = col;
+			}
+		}
+	}
+	return best >= 0;
+}
+
+int EnemyCrowd::add(const int room, const int slot, float r, float c, const float yaw, std::vector<uint8_t> state)
+{
+	//spawn points and enemies leaving through a door can sit on a wall or in the gap, a proxy starts on the floor
+	int cellRow = static_cast<int>(std::lround(r));
+	int cellCol = static_cast<int>(std::lround(c));
+	unless(isFloor(room, cellRow, cellCol))
+	{
+		if (nearestFloor(room, cellRow, cellCol))
+		{
+			r = static_cast<float>(cellRow);
+			c = static_cast<float>(cellCol);
+		}
+	}
+	rows.push_back(r);
+	cols.push_back(c);
+	yaws.push_back(yaw);
+	targetRows.push_back(cellRow);
+	targetCols.push_back(cellCol);
+	waits.push_back(MAX_WAIT * static_cast<float>(rg.getRandom(0, 10)) / 10.f);
+	rooms.push_back(room);
+	slots.push_back(slot);
+	states.push_back(std::move(state));
+	return static_cast<int>(rows.size()) - 1;
+}
+
+void EnemyCrowd::remove(const int index)
+{
+	const size_t last = rows.size() - 1;
+	rows[index] = rows[last];
+	cols[index] = cols[last];
+	yaws[index] = yaws[last];
+	targetRows[index] = targetRows[last];
+	targetCols[index] = targetCols[last];
+	waits[index] = waits[last];
+	rooms[index] = rooms[last];
+	slots[index] = slots[last];
+	states[index] = std::move(states[last]);
+	rows.pop_back();
+	cols.pop_back();
+	yaws.pop_back();
+	targetRows.pop_back();
+	targetCols.pop_back();
+	waits.pop_back();
+	rooms.pop_back();
+	slots.pop_back();
+	states.pop_back();
+}
+
+void EnemyCrowd::clear()
+{
+	rows.clear();
+	cols.clear();
+	yaws.clear();
+	targetRows.clear();
+	targetCols.clear();
+	waits.clear();
+	rooms.clear();
+	slots.clear();
+	states.clear();
+}
+
+void EnemyCrowd::step(const float seconds)
+{
+	const int count = getCount();
+	for (int i = 0; i < count; i++)
+	{
+		if (waits[i] > 0.f)
+		{
+			waits[i] -= seconds;
+			if (waits[i] <= 0.f)
+			{
+				pickTarget(i);
+			}
+			continue;
+		}
+
+		//rows first and then columns, so a proxy only ever walks along the grid
+		const float dr = static_cast<float>(targetRows[i]) - rows[i];
+		const float dc = static_cast<float>(targetCols[i]) - cols[i];
+		const bool alongRow = dr != 0.f;
+		const float distance = std::fabs(alongRow ? dr : dc);
+		if (distance == 0.f)
+		{
+			waits[i] = MAX_WAIT * static_cast<float>(rg.getRandom(1, 10)) / 10.f;
+			continue;
+		}
+
+		const float move = std::min(distance, speed * seconds);
+		float r = rows[i];
+		float c = cols[i];
+		if (alongRow)
+		{
+			r += std::copysign(move, dr);
+			yaws[i] = dr > 0.f ? 0.f : 180.f;
+		}
+		else
+		{
+			c += std::copysign(move, dc);
+			yaws[i] = dc > 0.f ? 90.f : 270.f;
+		}
+
+		//a straight line across an L or U shape can leave the room, the proxy turns around at the wall instead
+		unless(isFloor(rooms[i], static_cast<int>(std::lround(r)), static_cast<int>(std::lround(c))))
+		{
+			targetRows[i] = static_cast<int>(std::lround(rows[i]));
+			targetCols[i] = static_cast<int>(std::lround(cols[i]));
+			rows[i] = static_cast<float>(targetRows[i]);
+			cols[i] = static_cast<float>(targetCols[i]);
+			continue;
+		}
+		rows[i] = r;
+		cols[i] = c;
+	}
+}
+
+int EnemyCrowd::getCount() const
+{
+	return static_cast<int>(rows.size());
+}
+
+int EnemyCrowd::getRoom(const int index) const
+{
+	return rooms[index];
+}
+
+int EnemyCrowd::getSlot(const int index) const
+{
+	return slots[index];
+}
+
+float EnemyCrowd::getRow(const int index) const
+{
+	return rows[index];
+}
+
+float EnemyCrowd::getCol(const int index) const
+{
+	return cols[index];
+}
+
+float EnemyCrowd::getYaw(const int index) const
+{
+	return yaws[index];
+}
+
+const std::vector<uint8_t>& EnemyCrowd::getState(const int index) const
+{
+	return states[index];
+}
@@ -0,0 +1,231 @@
+#include "FieldOfView.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+	//how each of the eight octants maps its (dx, dy) onto columns and rows
+	constexpr int OCTANTS[4][8] = {
+		{1, 0, 0, -1, -1, 0, 0, 1},
+		{0, 1, -1, 0, 0, -1, 1, 0},
+		{0, 1, 1, 0, 0, -1, -1, 0},
+		{1, 0, 0, 1, -1, 0, 0, -1}
+	};
+}
+
+FieldOfView::FieldOfView(const WallGrid& walls, const int radius)
+	: walls(walls), radius(std::max(1, radius)), size(walls.getSize()), words(walls.getWords()),
+	  visible(static_cast<size_t>(walls.getSize()) * walls.getWords(), 0),
+	  explored(static_cast<size_t>(walls.getSize()) * walls.getWords(), 0),
+	  originR(-1), originC(-1), firstRow(0), lastRow(-1), firstWord(0), lastWord(-1)
+{
+}
+
+void FieldOfView::markVisible(const int r, const int c)
+{
+	if (r >= 0 && c >= 0 && r < size && c < size)
+	{
+		visible[static_cast<size_t>(r) * words + c / 64] |= uint64_t(1) << (c % 64);
+	}
+}
+
+void FieldOfView::castLight(const int row, float start, const float end, const int xx, const int xy, const int yx,
+                            const int yy)
+{
+	//start and end are the slopes still lit, a wall seen on this row starts a shadow the next rows inherit
+	if (start < end)
+	{
+		return;
+	}
+	const int squared = radius * radius;
+	float nextStart = start;
+	for (int j = row; j <= radius; j++)
+	{
+		bool blocked = false;
+		const int dy = -j;
+		for (int dx = -j; dx <= 0; dx++)
+		{
+			const float leftSlope = (static_cast<float>(dx) - 0.5f) / (static_cast<float>(dy) + 0.5f);
+			const float rightSlope = (static_cast<float>(dx) + 0.5f) / (static_cast<float>(dy) - 0.5f);
+			if (start < rightSlope)
+			{
+				continue;
+			}
+			if (end > leftSlope)
+			{
+				break;
+			}
+			const int c = originC + dx * xx + dy * xy;
+			const int r = originR + dx * yx + dy * yy;
+			if (dx * dx + dy * dy <= squared)
+			{
+				markVisible(r, c);
+			}
+			const bool wall = walls.isWall(r, c);
+			if (blocked)
+			{
+				if (wall)
+				{
+					nextStart = rightSlope;
+					continue;
+				}
+				blocked = false;
+				start = nextStart;
+			}
+			else if (wall && j < radius)
+			{
+				blocked = true;
+				castLight(j + 1, start, leftSlope, xx, xy, yx, yy);
+				nextStart = rightSlope;
+			}
+		}
+		if (blocked)
+		{
+			break;
+		}
+	}
+}
+
+void FieldOfView::appendRuns(const int r, const int w, uint64_t bits, std::vector<CellSpan>& out)
+{
+	while (bits)
+	{
+		const int from = std::countr_zero(bits);
+		const int length = std::countr_one(bits >> from);
+		const int first = w * 64 + from;
+		if (!out.empty() && out.back().r == r && out.back().to == first)
+		{
+			out.back().to = first + length;
+		}
+		else
+		{
+			out.push_back({r, first, first + length});
+		}
+		bits = from + length >= 64 ? 0 : bits & ~uint64_t(0) << (from + length);
+	}
+}
+
+bool FieldOfView::update(const int r, const int c)
+{
+	if (r == originR && c == originC)
+	{
+		return false;
+	}
+	changed.clear();
+	discovered.clear();
+
+	//the old window is set aside and cleared, everything outside it is already clear
+	const int oldFirstRow = firstRow;
+	const int oldLastRow = lastRow;
+	const int oldFirstWord = firstWord;
+	const int oldLastWord = lastWord;
+	const int oldWords = oldLastWord - oldFirstWord + 1;
+	previous.clear();
+	for (int row = oldFirstRow; row <= oldLastRow; row++)
+	{
+		uint64_t* line = visible.data() + static_cast<size_t>(row) * words;
+		previous.insert(previous.end(), line + oldFirstWord, line + oldLastWord + 1);
+		std::fill(line + oldFirstWord, line + oldLastWord + 1, 0);
+	}
+
+	originR = r;
+	originC = c;
+	//clamped on both sides, an origin further than radius off the floor leaves the window empty
+	firstRow = std::max(0, r - radius);
+	lastRow = std::min(size - 1, r + radius);
+	const int firstCol = std::max(0, c - radius);
+	const int lastCol = std::min(size - 1, c + radius);
+	const bool hasWindow = firstRow <= lastRow && firstCol <= lastCol;
+	if (hasWindow)
+	{
+		firstWord = firstCol / 64;
+		lastWord = lastCol / 64;
+		markVisible(r, c);
+		for (int octant = 0; octant < 8; octant++)
+		{
+			castLight(1, 1.f, 0.f, OCTANTS[0][octant], OCTANTS[1][octant], OCTANTS[2][octant], OCTANTS[3][octant]);
+		}
+	}
+	else
+	{
+		firstRow = 0;
+		lastRow = -1;
+		firstWord = 0;
+		lastWord = -1;
+	}
+
+	//both windows together, a word at a time
+	const bool hadWindow = oldFirstRow <= oldLastRow && oldFirstWord <= oldLastWord;
+	if (!hadWindow && !hasWindow)
+	{
+		return true;
+	}
+	const int fromRow = !hadWindow ? firstRow : !hasWindow ? oldFirstRow : std::min(firstRow, oldFirstRow);
+	const int toRow = std::max(lastRow, oldLastRow);
+	const int fromWord = !hadWindow ? firstWord : !hasWindow ? oldFirstWord : std::min(firstWord, oldFirstWord);
+	const int toWord = std::max(lastWord, oldLastWord);
+	for (int row = fromRow; row <= toRow; row++)
+	{
+		const bool inOld = row >= oldFirstRow && row <= oldLastRow;
+		for (int w = fromWord; w <= toWord; w++)
+		{
+			const size_t index = static_cast<size_t>(row) * words + w;
+			const uint64_t before = inOld && w >= oldFirstWord && w <= oldLastWord
+				                        ? previous[static_cast<size_t>(row - oldFirstRow) * oldWords + (w - oldFirstWord)]
+				                        : 0;
+			const uint64_t now = visible[index];
+			appendRuns(row, w, before ^ now, changed);
+			appendRuns(row, w, now & ~explored[index], discovered);
+			explored[index] |= now;
+		}
+	}
+	return true;
+}
+
+void FieldOfView::reset()
+{
+	std::fill(visible.begin(), visible.end(), 0);
+	std::fill(explored.begin(), explored.end(), 0);
+	originR = -1;
+	originC = -1;
+	firstRow = 0;
+	lastRow = -1;
+	firstWord = 0;
+	lastWord = -1;
+	changed.clear();
+	discovered.clear();
+}
+
+const std::vector<CellSpan>& FieldOfView::getChanged() const
+{
+	return changed;
+}
+
+const std::vector<CellSpan>& FieldOfView::getDiscovered() const
+{
+	return discovered;
+}
+
+bool FieldOfView::isVisible(const int r, const int c) const
+{
+	if (r < 0 || c < 0 || r >= size || c >= size)
+	{
+		return false;
+	}
+	return visible[static_cast<size_t>(r) * words + c / 64] >> (c % 64) & 1;
+}
+
+bool FieldOfView::isExplored(const int r, const int c) const
+{
+	if (r < 0 || c < 0 || r >= size || c >= size)
+	{
+		return false;
+	}
+	return explored[static_cast<size_t>(r) * words + c / 64] >> (c % 64) & 1;
+}
+
+int FieldOfView::getRadius() const
+{
+	return radius;
+}
@@ -0,0 +1,102 @@
+#include "FloorDelta.h"
+
+#include <algorithm>
+
+FloorDelta::FloorDelta()
+	: firstSlot(1, 0)
+{
+}
+
+FloorDelta::FloorDelta(const FloorPlan& plan)
+{
+	firstSlot.reserve(plan.getRooms().size() + 1);
+	int slots = 0;
+	for (const auto& room : plan.getRooms())
+	{
+		firstSlot.push_back(slots);
+		slots += static_cast<int>(room.spawns.size());
+	}
+	firstSlot.push_back(slots);
+	bits.assign((slots + 7) / 8, 0);
+}
+
+int FloorDelta::getRoomCount() const
+{
+	return static_cast<int>(firstSlot.size()) - 1;
+}
+
+int FloorDelta::getSlotCount() const
+{
+	return firstSlot.back();
+}
+
+int FloorDelta::getSlotCount(const int room) const
+{
+	if (room < 0 || room >= getRoomCount())
+	{
+		return 0;
+	}
+	return firstSlot[room + 1] - firstSlot[room];
+}
+
+int FloorDelta::toIndex(const int room, const int slot) const
+{
+	if (slot < 0 || slot >= getSlotCount(room))
+	{
+		return -1;
+	}
+	return firstSlot[room] + slot;
+}
+
+void FloorDelta::set(const int room, const int slot, const bool value)
+{
+	const int index = toIndex(room, slot);
+	if (index < 0)
+	{
+		return;
+	}
+	if (value)
+	{
+		bits[index / 8] |= static_cast<uint8_t>(1u << index % 8);
+	}
+	else
+	{
+		bits[index / 8] &= static_cast<uint8_t>(~(1u << index % 8));
+	}
+}
+
+bool FloorDelta::test(const int room, const int slot) const
+{
+	const int index = toIndex(room, slot);
+	return index >= 0 && bits[index / 8] >> index % 8 & 1;
+}
+
+bool FloorDelta::any() const
+{
+	return std::any_of(bits.begin(), bits.end(), [](const uint8_t byte) { return byte != 0; });
+}
+
+void FloorDelta::clear()
+{
+	std::fill(bits.begin(), bits.end(), 0);
+}
+
+const std::vector<uint8_t>& FloorDelta::getBytes() const
+{
+	return bits;
+}
+
+bool FloorDelta::setBytes(const uint8_t* data, const size_t count)
+{
+	if (count != bits.size())
+	{
+		return false;
+	}
+	std::copy_n(data, count, bits.begin());
+	//padding bits past the last slot stay clear so equal deltas compare equal
+	if (const int used = getSlotCount() % 8)
+	{
+		bits.back() &= static_cast<uint8_t>((1u << used) - 1);
+	}
+	return true;
+}
@@ -0,0 +1,616 @@
+#include "FloorPlan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory_resource>
+#include <utility>
+
+#include "TaskPool.h"
+
+namespace
+{
+	//lays out one room's wall instances the way ARoom used to build them in the world
+	class RoomPlanner
+	{
+		RoomPlan& plan;
+
+		void buildWallSegment(const float r, const float c, const float alty, const float rScale,
+		                      const float cScale, const float zScale) const
+		{
+			if (rScale == 0 || cScale == 0 || zScale == 0)
+			{
+				return;
+			}
+			plan.segments.push_back({r, c, alty, rScale, cScale, zScale});
+		}
+
+		void buildWall(CellList& walls)
+		{
+			bool isVert = true;
+			std::pair<int, int>* p1 = nullptr;
+
+			for (auto& p2 : walls)
+			{
+				if (p1)
+				{
+					isVert ? buildVerticalWall(*p1, p2) : buildHorizontalWall(*p1, p2);
+					isVert = !isVert;
+				}
+				p1 = &p2;
+			}
+			unless(p1 == nullptr)
+			{
+				isVert ? buildVerticalWall(*p1, walls[0]) : buildHorizontalWall(*p1, walls[0]);
+			}
+		}
+
+		void buildVerticalWall(const std::pair<int, int>& p1, const std::pair<int, int>& p2)
+		{
+			int row = std::min(p1.first, p2.first);
+			int rScale = 0;
+			int rStart = row;
+
+			//loops over the row
+			//scale & loop begins at 1 and row because corners are never doors
+			for (int r = row; r < std::max(p1.first, p2.first) + 1; r++)
+			{
+				//if there is no door then increase the length of the wall segment
+				unless(plan.room.getDoors().contains({r, p1.second}))
+				{
+					rScale++;
+				}
+				//if there is a door then build a segment from the starting position with the pos and scale
+				else
+				{
+					buildWallSegment(rStart, p1.second, 0, rScale, 1, /*door height*/3);
+					rScale = 0;
+					rStart = r + 1;
+				}
+			}
+
+			//builds the final segment
+			//if there were no doors, builds the whole wall
+			buildWallSegment(rStart, p1.second, 0, rScale, 1, /*door height*/3);
+		}
+
+		void buildHorizontalWall(const std::pair<int, int>& p1, const std::pair<int, int>& p2)
+		{
+			int col = std::min(p1.second, p2.second) + 1;
+			int cScale = 0;
+			int cStart = col;
+			//loops over the col
+			//scale & loop begins at 1 and row because corners are never doors
+			for (int c = col; c < std::max(p1.second, p2.second); c++)
+			{
+				//if there is no door then increase the length of the wall segment
+				unless(plan.room.getDoors().contains({p1.first, c}))
+				{
+					cScale++;
+				}
+				//if there is a door then build a segment from the starting position with the pos and scale
+				else
+				{
+					buildWallSegment(p1.first, cStart, 0, 1, cScale, /*door height*/3);
+					cScale = 0;
+					cStart = c + 1;
+				}
+			}
+			//builds the final segment
+			//if there were no doors, builds the whole wall
+			if (cScale > 0)
+			{
+				buildWallSegment(p1.first, cStart, 0, 1, cScale, /*door height*/3);
+			}
+		}
+
+		void buildOverheads() const
+		{
+			const unsigned int width = plan.room.getWidth();
+			const unsigned int height = plan.room.getHeight();
+			int r1 = -1;
+			int c1 = -1;
+			int r2 = height;
+			int c2 = width;
+			unsigned int doorHeight = 3;
+			unsigned int zScale = plan.alt - doorHeight;
+
+			//builds four overhead walls
+			buildWallSegment(r1, c1, doorHeight, height + 2, 1, zScale);
+			buildWallSegment(r1, c2, doorHeight, height + 2, 1, zScale);
+			//rows is increased and width is decreased so that overhead walls do not overlap
+			buildWallSegment(r1, c1 + 1, doorHeight, 1, width, zScale);
+			buildWallSegment(r2, c1 + 1, doorHeight, 1, width, zScale);
+		}
+
+	public:
+		explicit RoomPlanner(RoomPlan& plan)
+			: plan(plan)
+		{
+		}
+
+		void build()
+		{
+			//builds the ceiling
+			buildWallSegment(0, 0, static_cast<float>(plan.alt - 0.2), plan.room.getHeight(), plan.room.getWidth(), 0.2f);
+
+			//builds the walls
+			buildOverheads();
+			buildWall(plan.room.getWalls());
+			buildWall(plan.room.getInteriorWalls());
+		}
+	};
+}
+
+RoomPlan FloorPlan::planRoom(const RoomImpl& room, RandomGenerator& rg)
+{
+	//the shared stream only hands out the altitude, spawns are planned for the whole floor at once
+	RoomPlan plan{room, static_cast<unsigned int>(rg.getRandom(4, 7)), {}, {}, {}};
+
+	if (plan.room.getDoors().empty())
+	{
+		return plan;
+	}
+
+	RoomPlanner(plan).build();
+	return plan;
+}
+
+FloorPlan::FloorPlan(const int size, const int room_min, const int room_max, const int gap, const unsigned int seed,
+                     std::pmr::memory_resource* memory)
+	: size(size), room_min(room_min), room_max(room_max), gap(gap), seed(seed), complete(false), memory(memory),
+	  placementCheck(nullptr), layoutOnly(false)
+{
+}
+
+FloorPlan::~FloorPlan() = default;
+
+void FloorPlan::setPlacementCheck(const PlacementCheck* check)
+{
+	placementCheck = check;
+}
+
+void FloorPlan::setLayoutOnly(const bool only)
+{
+	layoutOnly = only;
+}
+
+void FloorPlan::setBoundary(std::shared_ptr<const BoundaryMask> mask)
+{
+	boundary = std::move(mask);
+}
+
+bool FloorPlan::generate(GenerationLog* log, const std::atomic<bool>* cancel)
+{
+	const GenerationStatus status = generate(GenerationBudget(), log, cancel).status;
+	return status != GenerationStatus::Cancelled && status != GenerationStatus::Rejected;
+}
+
+bool FloorPlan::prepare(GenerationLog* log, const std::atomic<bool>* cancel)
+{
+	unless(generator)
+	{
+		if (complete)
+		{
+			return false;
+		}
+		generator = std::make_unique<GeneratorImpl>(size, room_min, room_max, gap, static_cast<int>(seed), memory);
+	}
+	generator->setBoundary(boundary.get());
+	generator->setLog(log);
+	generator->setCancel(cancel);
+	generator->setPlacementCheck(placementCheck);
+	return true;
+}
+
+GenerationReport FloorPlan::generate(const GenerationBudget& budget, GenerationLog* log,
+                                     const std::atomic<bool>* cancel)
+{
+	unless(prepare(log, cancel))
+	{
+		return report;
+	}
+	report = generator->generate(budget);
+	return planFloor(cancel);
+}
+
+GenerationReport FloorPlan::resume(const GenerationBudget& budget, GenerationLog* log,
+                                   const std::atomic<bool>* cancel)
+{
+	unless(prepare(log, cancel))
+	{
+		return report;
+	}
+	report = generator->generate(budget);
+	if (report.status == GenerationStatus::Partial)
+	{
+		return report;
+	}
+	return planFloor(cancel);
+}
+
+GenerationStep FloorPlan::step(GenerationLog* log)
+{
+	unless(prepare(log, nullptr))
+	{
+		return GenerationStep::Done;
+	}
+	const GenerationStep reached = generator->step();
+	report = generator->getReport();
+	if (reached == GenerationStep::Done)
+	{
+		planFloor(nullptr);
+	}
+	else
+	{
+		planSteppedRooms();
+	}
+	return reached;
+}
+
+void FloorPlan::planSteppedRooms()
+{
+	//only the newest room can have changed since the last step, every one before it is kept as it was planned
+	const RoomList& placed = generator->getRooms();
+	const size_t kept = std::min(rooms.size(), placed.empty() ? 0 : placed.size() - 1);
+	rooms.erase(rooms.begin() + static_cast<std::ptrdiff_t>(kept), rooms.end());
+	for (size_t i = kept; i < placed.size(); i++)
+	{
+		RandomGenerator rg((seed ^ STEP_STREAM) + static_cast<unsigned int>(i));
+		rooms.push_back(planRoom(placed[i], rg));
+	}
+}
+
+GenerationReport FloorPlan::planFloor(const std::atomic<bool>* cancel)
+{
+	rooms.clear();
+	if (report.status == GenerationStatus::Cancelled || report.status == GenerationStatus::Rejected)
+	{
+		generator.reset();
+		return report;
+	}
+
+	//a partial floor is planned from a copy of the generator's rng, so carrying on later still ends in the
+	//same floor an unbudgeted run would have made
+	const bool partial = report.status == GenerationStatus::Partial;
+	RandomGenerator partialRg = generator->getRandomGenerator();
+	RandomGenerator& rg = partial ? partialRg : generator->getRandomGenerator();
+
+	rooms.reserve(generator->getRooms().size());
+	for (const auto& room : generator->getRooms())
+	{
+		if (cancel && cancel->load())
+		{
+			rooms.clear();
+			generator.reset();
+			report.status = GenerationStatus::Cancelled;
+			return report;
+		}
+		rooms.push_back(planRoom(room, rg));
+	}
+	planSpawns();
+	graph.build(generator->getRooms(), generator->getRoomIds(), gap);
+	unless(layoutOnly)
+	{
+		planInteriors();
+		planWalls();
+		generator->routeCorridors(graph);
+		//the plan outlives the generator's memory, so its rooms and corridors are copied out onto the heap
+		corridors.assign(generator->getCorridors().begin(), generator->getCorridors().end());
+		planCorridors();
+		planColliders();
+		paths.build(graph, walls, corridors, props);
+	}
+
+	unless(partial)
+	{
+		complete = true;
+		generator.reset();
+	}
+	return report;
+}
+
+const GenerationReport& FloorPlan::getReport() const
+{
+	return report;
+}
+
+void FloorPlan::planSpawns()
+{
+	spawns.clear();
+	//a stream of its own, so the rooms' altitudes draw the same numbers whatever the spawn settings
+	RandomGenerator rg(seed ^ SPAWN_STREAM);
+	SpawnPlanner(size).plan(generator->getRooms(), rg, spawns);
+	for (const auto& spawn : spawns)
+	{
+		RoomPlan& plan = rooms[spawn.room];
+		const auto r = static_cast<float>(spawn.r - static_cast<int>(plan.room.getRow()));
+		const auto c = static_cast<float>(spawn.c - static_cast<int>(plan.room.getCol()));
+		plan.spawns.push_back({spawn.kind, r * 100.f, c * 100.f});
+	}
+}
+
+void FloorPlan::planWalls()
+{
+	//the same loops RoomImpl draws into the generator's grid, minus the doors cut into them
+	walls = WallGrid(size);
+	for (const auto& plan : rooms)
+	{
+		const RoomImpl& room = plan.room;
+		const int row = static_cast<int>(room.getRow());
+		const int col = static_cast<int>(room.getCol());
+		for (const CellList* loop : {&room.getWalls(), &room.getInteriorWalls()})
+		{
+			for (size_t i = 0; i < loop->size(); i++)
+			{
+				const auto& [r0, c0] = (*loop)[i];
+				const auto& [r1, c1] = (*loop)[(i + 1) % loop->size()];
+				const int steps = std::max(std::abs(r1 - r0), std::abs(c1 - c0));
+				for (int k = 0; k <= steps; k++)
+				{
+					const int r = r0 + (r1 > r0) * k - (r1 < r0) * k;
+					const int c = c0 + (c1 > c0) * k - (c1 < c0) * k;
+					unless(room.getDoors().contains({r, c}))
+					{
+						walls.set(row + r, col + c, true);
+					}
+				}
+			}
+		}
+	}
+}
+
+void FloorPlan::planInteriors()
+{
+	TaskPool::shared().parallelFor(static_cast<int>(rooms.size()), [this](const int index)
+	{
+		RoomPlan& plan = rooms[index];
+		plan.props.clear();
+		const RoomImpl& room = plan.room;
+		if (room.getDoors().empty() || !RoomStamp::fits(static_cast<int>(room.getHeight()), static_cast<int>(room.getWidth())))
+		{
+			return;
+		}
+
+		//every room draws from a stream of its own, so it comes out the same whichever thread solves it
+		RandomGenerator rg(seed ^ (static_cast<unsigned int>(index) + 1u) * 0x9E3779B9u);
+		RoomInterior interior(room.getStamp());
+		for (const auto& spawn : plan.spawns)
+		{
+			interior.reserve(static_cast<int>(std::lround(spawn.x / 100.f)), static_cast<int>(std::lround(spawn.y / 100.f)));
+		}
+		interior.solve(rg, plan.props);
+	});
+
+	for (auto& list : props)
+	{
+		list.clear();
+	}
+	for (const auto& plan : rooms)
+	{
+		for (PropInstance prop : plan.props)
+		{
+			prop.r += static_cast<int>(plan.room.getRow());
+			prop.c += static_cast<int>(plan.room.getCol());
+			props[static_cast<size_t>(prop.kind)].push_back(prop);
+		}
+	}
+}
+
+void FloorPlan::planCorridors()
+{
+	corridorSegments.clear();
+	std::vector<unsigned char> cells(static_cast<size_t>(size) * size, 0);
+	for (const auto& corridor : corridors)
+	{
+		for (const auto& [r, c] : corridor.cells)
+		{
+			//the doors at either end already have a floor inside their room
+			if (graph.getRoomIds().get(r, c) < 0)
+			{
+				cells[r * size + c] = 1;
+			}
+		}
+	}
+
+	mergeCells(cells, size, 0, 0.f, CORRIDOR_HEIGHT, corridorSegments);
+}
+
+void FloorPlan::mergeCells(const std::vector<unsigned char>& cells, const int width, const int origin, const float alt,
+                           const float zScale, std::vector<WallSegment>& out)
+{
+	//runs along each row, stacked with the identical run of the row below into one box
+	std::vector<WallSegment> active;
+	std::vector<WallSegment> next;
+	for (int r = 0; r <= width; r++)
+	{
+		next.clear();
+		size_t a = 0;
+		for (int c = 0; r < width && c < width; c++)
+		{
+			if (!cells[r * width + c])
+			{
+				continue;
+			}
+			const int start = c;
+			while (c < width && cells[r * width + c])
+			{
+				c++;
+			}
+			const auto length = static_cast<float>(c - start);
+			const auto left = static_cast<float>(start + origin);
+			while (a < active.size() && active[a].c < left)
+			{
+				out.push_back(active[a++]);
+			}
+			if (a < active.size() && active[a].c == left && active[a].cScale == length)
+			{
+				WallSegment grown = active[a++];
+				grown.rScale++;
+				next.push_back(grown);
+			}
+			else
+			{
+				next.push_back({static_cast<float>(r + origin), left, alt, 1.f, length, zScale});
+			}
+		}
+		out.insert(out.end(), active.begin() + static_cast<std::ptrdiff_t>(a), active.end());
+		std::swap(active, next);
+	}
+}
+
+void FloorPlan::planColliders()
+{
+	colliders.clear();
+
+	//every wall, overhead and ceiling box in dungeon cells, grouped by the height band it fills
+	std::vector<WallSegment> boxes;
+	for (const auto& plan : rooms)
+	{
+		for (WallSegment segment : plan.segments)
+		{
+			segment.r += static_cast<float>(plan.room.getRow());
+			segment.c += static_cast<float>(plan.room.getCol());
+			boxes.push_back(segment);
+		}
+	}
+	std::sort(boxes.begin(), boxes.end(), [](const WallSegment& a, const WallSegment& b)
+	{
+		return a.alt != b.alt ? a.alt < b.alt : a.zScale < b.zScale;
+	});
+
+	//overheads hang one cell outside their room, so the bands are rasterized with a cell of margin
+	const int width = size + 2;
+	std::vector<unsigned char> cells(static_cast<size_t>(width) * width);
+	for (size_t first = 0; first < boxes.size();)
+	{
+		size_t last = first;
+		std::fill(cells.begin(), cells.end(), 0);
+		for (; last < boxes.size() && boxes[last].alt == boxes[first].alt && boxes[last].zScale == boxes[first].zScale; last++)
+		{
+			const WallSegment& box = boxes[last];
+			const int r0 = std::max(static_cast<int>(box.r) + 1, 0);
+			const int c0 = std::max(static_cast<int>(box.c) + 1, 0);
+			const int r1 = std::min(static_cast<int>(box.r + box.rScale) + 1, width);
+			const int c1 = std::min(static_cast<int>(box.c + box.cScale) + 1, width);
+			for (int r = r0; r < r1; r++)
+			{
+				std::fill(cells.begin() + r * width + c0, cells.begin() + r * width + std::max(c0, c1), 1);
+			}
+		}
+		mergeCells(cells, width, -1, boxes[first].alt, boxes[first].zScale, colliders);
+		first = last;
+	}
+}
+
+bool FloorPlan::isComplete() const
+{
+	return complete;
+}
+
+const std::vector<RoomPlan>& FloorPlan::getRooms() const
+{
+	return rooms;
+}
+
+const RoomGraph& FloorPlan::getGraph() const
+{
+	return graph;
+}
+
+const std::vector<Corridor>& FloorPlan::getCorridors() const
+{
+	return corridors;
+}
+
+const std::vector<WallSegment>& FloorPlan::getCorridorSegments() const
+{
+	return corridorSegments;
+}
+
+const std::vector<WallSegment>& FloorPlan::getColliders() const
+{
+	return colliders;
+}
+
+const std::vector<PropInstance>& FloorPlan::getProps(const PropKind kind) const
+{
+	return props[static_cast<size_t>(kind)];
+}
+
+const std::vector<PlannedSpawn>& FloorPlan::getSpawns() const
+{
+	return spawns;
+}
+
+const WallGrid& FloorPlan::getWalls() const
+{
+	return walls;
+}
+
+const RoomPaths& FloorPlan::getPaths() const
+{
+	return paths;
+}
+
+size_t FloorPlan::getMemoryUsage() const
+{
+	size_t bytes = sizeof(FloorPlan) + rooms.capacity() * sizeof(RoomPlan);
+	for (const auto& plan : rooms)
+	{
+		const RoomImpl& room = plan.room;
+		bytes += plan.segments.capacity() * sizeof(WallSegment);
+		bytes += plan.spawns.capacity() * sizeof(SpawnPoint);
+		bytes += plan.props.capacity() * sizeof(PropInstance);
+		bytes += (room.getWalls().capacity() + room.getInteriorWalls().capacity()) * sizeof(std::pair<int, int>);
+		//std::set nodes carry three pointers and a colour on top of the value
+		bytes += room.getDoors().size() * (sizeof(std::pair<int, int>) + 4 * sizeof(void*));
+	}
+	for (const auto& corridor : corridors)
+	{
+		bytes += sizeof(Corridor) + corridor.cells.capacity() * sizeof(std::pair<int, int>);
+	}
+	bytes += (corridorSegments.capacity() + colliders.capacity()) * sizeof(WallSegment);
+	bytes += spawns.capacity() * sizeof(PlannedSpawn) + walls.getMemoryUsage() + paths.getMemoryUsage();
+	for (const auto& list : props)
+	{
+		bytes += list.capacity() * sizeof(PropInstance);
+	}
+	if (generator)
+	{
+		bytes += estimateMemoryUsage(size);
+	}
+	return bytes + graph.getRoomIds().getMemoryUsage();
+}
+
+size_t FloorPlan::estimateMemoryUsage(const int size)
+{
+	//the generator's character grid and room-id layer dominate while a floor is being built, the wall bits stay
+	return static_cast<size_t>(size) * (size + 1) + static_cast<size_t>(size) * size * sizeof(uint16_t)
+		+ static_cast<size_t>(size) * ((size + 63) / 64) * sizeof(uint64_t) + sizeof(FloorPlan);
+}
+
+int FloorPlan::getSize() const
+{
+	return size;
+}
+
+int FloorPlan::getRoomMin() const
+{
+	return room_min;
+}
+
+int FloorPlan::getRoomMax() const
+{
+	return room_max;
+}
+
+int FloorPlan::getGap() const
+{
+	return gap;
+}
+
+unsigned int FloorPlan::getSeed() const
+{
+	return seed;
+}
@@ -0,0 +1,79 @@
+#include "GenerationArena.h"
+
+#include <algorithm>
+
+void* GenerationArena::Upstream::do_allocate(const size_t count, const size_t alignment)
+{
+	allocations++;
+	bytes += count;
+	return std::pmr::new_delete_resource()->allocate(count, alignment);
+}
+
+void GenerationArena::Upstream::do_deallocate(void* pointer, const size_t count, const size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(pointer, count, alignment);
+}
+
+bool GenerationArena::Upstream::do_is_equal(const memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+GenerationArena::GenerationArena(const size_t initialBytes)
+	: block(std::make_unique<std::byte[]>(initialBytes)), blockSize(initialBytes), allocations(0), used(0)
+{
+	buffer.emplace(block.get(), blockSize, &upstream);
+}
+
+void* GenerationArena::do_allocate(const size_t count, const size_t alignment)
+{
+	allocations++;
+	used += count;
+	return buffer->allocate(count, alignment);
+}
+
+void GenerationArena::do_deallocate(void*, size_t, size_t)
+{
+	//monotonic, memory only comes back on reset
+}
+
+bool GenerationArena::do_is_equal(const memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+void GenerationArena::reset()
+{
+	buffer.reset();
+	if (upstream.allocations)
+	{
+		//room for everything the last run needed, with headroom for alignment and a slightly bigger floor
+		blockSize = std::max(blockSize * 2, (blockSize + upstream.bytes) * 5 / 4);
+		block = std::make_unique<std::byte[]>(blockSize);
+	}
+	upstream.allocations = 0;
+	upstream.bytes = 0;
+	allocations = 0;
+	used = 0;
+	buffer.emplace(block.get(), blockSize, &upstream);
+}
+
+size_t GenerationArena::getAllocations() const
+{
+	return allocations;
+}
+
+size_t GenerationArena::getUsedBytes() const
+{
+	return used;
+}
+
+size_t GenerationArena::getSpills() const
+{
+	return upstream.allocations;
+}
+
+size_t GenerationArena::getCapacity() const
+{
+	return blockSize;
+}
@@ -0,0 +1,245 @@
+#include "GenerationLog.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "Relics/Utils/Utils.h"
+
+void GenerationLog::writeVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<uint8_t>(value));
+}
+
+void GenerationLog::writeSigned(const int64_t value)
+{
+	writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void GenerationLog::writeEvent(const GenerationEvent type)
+{
+	const auto now = std::chrono::steady_clock::now();
+	bytes.push_back(static_cast<uint8_t>(type));
+	writeVarint(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+	last = now;
+}
+
+GenerationLog::GenerationLog()
+	: size(0), lastProbe(0)
+{
+}
+
+void GenerationLog::begin(const int size, const int room_min, const int room_max, const int gap,
+                          const unsigned int seed)
+{
+	bytes.clear();
+	for (const char ch : MAGIC)
+	{
+		bytes.push_back(static_cast<uint8_t>(ch));
+	}
+	writeVarint(size);
+	writeVarint(room_min);
+	writeVarint(room_max);
+	writeVarint(gap);
+	writeVarint(seed);
+	this->size = size;
+	lastProbe = 0;
+	last = std::chrono::steady_clock::now();
+}
+
+void GenerationLog::mask()
+{
+	writeEvent(GenerationEvent::Mask);
+}
+
+void GenerationLog::probe(const GenerationEvent type, const int r, const int c)
+{
+	const int cell = r * size + c;
+	writeEvent(type);
+	writeSigned(cell - lastProbe);
+	lastProbe = cell;
+}
+
+void GenerationLog::place(const unsigned int id, const int r, const int c, const int w, const int h)
+{
+	writeEvent(GenerationEvent::Place);
+	writeVarint(id);
+	writeVarint(r);
+	writeVarint(c);
+	writeVarint(w);
+	writeVarint(h);
+}
+
+void GenerationLog::reshape(const unsigned int id, const unsigned char shape)
+{
+	writeEvent(GenerationEvent::Reshape);
+	writeVarint(id);
+	writeVarint(shape);
+}
+
+void GenerationLog::door(const unsigned int id, const int r, const int c)
+{
+	writeEvent(GenerationEvent::Door);
+	writeVarint(id);
+	writeSigned(r);
+	writeSigned(c);
+}
+
+void GenerationLog::retry(const int retries)
+{
+	writeEvent(GenerationEvent::Retry);
+	writeVarint(retries);
+}
+
+void GenerationLog::end(const bool result)
+{
+	writeEvent(GenerationEvent::End);
+	writeVarint(result ? 1 : 0);
+}
+
+const std::vector<uint8_t>& GenerationLog::getBytes() const
+{
+	return bytes;
+}
+
+bool GenerationLog::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	return static_cast<bool>(file);
+}
+
+bool GenerationLogReader::readVarint(uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && pos < bytes.size(); shift += 7)
+	{
+		const uint8_t b = bytes[pos++];
+		value |= static_cast<uint64_t>(b & 0x7f) << shift;
+		unless(b & 0x80)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GenerationLogReader::readSigned(int64_t& value)
+{
+	uint64_t raw;
+	unless(readVarint(raw))
+	{
+		return false;
+	}
+	value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+	return true;
+}
+
+GenerationLogReader::GenerationLogReader(const std::vector<uint8_t>& bytes)
+	: bytes(bytes), pos(0), lastProbe(0), size(0), room_min(0), room_max(0), gap(0), seed(0)
+{
+	if (bytes.size() < sizeof(GenerationLog::MAGIC) ||
+		!std::equal(GenerationLog::MAGIC, GenerationLog::MAGIC + sizeof(GenerationLog::MAGIC), bytes.begin()))
+	{
+		return;
+	}
+	pos = sizeof(GenerationLog::MAGIC);
+
+	uint64_t header[5];
+	for (auto& value : header)
+	{
+		unless(readVarint(value))
+		{
+			pos = 0;
+			return;
+		}
+	}
+	size = static_cast<int>(header[0]);
+	room_min = static_cast<int>(header[1]);
+	room_max = static_cast<int>(header[2]);
+	gap = static_cast<int>(header[3]);
+	seed = static_cast<unsigned int>(header[4]);
+}
+
+bool GenerationLogReader::valid() const
+{
+	return pos != 0;
+}
+
+bool GenerationLogReader::next(GenerationRecord& record)
+{
+	if (!valid() || pos >= bytes.size() || bytes[pos] >= static_cast<uint8_t>(GenerationEvent::Count))
+	{
+		return false;
+	}
+	record = {static_cast<GenerationEvent>(bytes[pos++]), 0, 0, 0, 0, 0, 0, 0};
+	unless(readVarint(record.nanos))
+	{
+		return false;
+	}
+
+	uint64_t v[5] = {};
+	int64_t s[2] = {};
+	switch (record.type)
+	{
+	case GenerationEvent::ProbeFit:
+	case GenerationEvent::ProbeSpace:
+		unless(readSigned(s[0]))
+		{
+			return false;
+		}
+		lastProbe += static_cast<int>(s[0]);
+		record.row = size ? lastProbe / size : 0;
+		record.col = size ? lastProbe % size : 0;
+		return true;
+	case GenerationEvent::Place:
+		for (auto& value : v)
+		{
+			unless(readVarint(value))
+			{
+				return false;
+			}
+		}
+		record.id = static_cast<int>(v[0]);
+		record.row = static_cast<int>(v[1]);
+		record.col = static_cast<int>(v[2]);
+		record.width = static_cast<int>(v[3]);
+		record.height = static_cast<int>(v[4]);
+		return true;
+	case GenerationEvent::Reshape:
+		unless(readVarint(v[0]) && readVarint(v[1]))
+		{
+			return false;
+		}
+		record.id = static_cast<int>(v[0]);
+		record.value = static_cast<int>(v[1]);
+		return true;
+	case GenerationEvent::Door:
+		unless(readVarint(v[0]) && readSigned(s[0]) && readSigned(s[1]))
+		{
+			return false;
+		}
+		record.id = static_cast<int>(v[0]);
+		record.row = static_cast<int>(s[0]);
+		record.col = static_cast<int>(s[1]);
+		return true;
+	case GenerationEvent::Retry:
+	case GenerationEvent::End:
+		unless(readVarint(v[0]))
+		{
+			return false;
+		}
+		record.value = static_cast<int>(v[0]);
+		return true;
+	default:
+		return true;
+	}
+}
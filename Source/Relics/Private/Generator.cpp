@@ -1,125 +1,181 @@
 ﻿#include "Generator.h"
 
+#include "DungeonCollisionComponent.h"
+#include "DungeonSaveGame.h"
 #include "GeneratorImpl.h"
 #include "NavigationSystem.h"
+#include "RelicsStats.h"
 #include "Room.h"
 #include "EngineUtils.h"
 #include "Components/BrushComponent.h"
 #include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/Texture2D.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
+#include "Async/Async.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
 #include "NavMesh/NavMeshBoundsVolume.h"
+#include "Net/UnrealNetwork.h"
 
 
-void AGenerator::buildBasePlate()
+void AGenerator::buildCorridors(const FloorPlan& plan)
 {
-	FMatrix transformMatrix = FMatrix(
-		FPlane(size * 1.0f, 0.0f, 0.0f, 0.0f),
-		FPlane(0.0f, size * 1.0f, 0.0f, 0.0f),
-		FPlane(0.0f, 0.0f, 1.0f, 0.0f),
-		FPlane(0.0f, 0.0f, -100.0f, 1.0f)
-	);
-
-	blocks->ClearInstances();
-	blocks->AddInstance(FTransform(transformMatrix));
+	RELICS_SCOPE(BuildCorridors);
+	TArray<FTransform> transforms;
+	transforms.Reserve(static_cast<int32>(plan.getCorridorSegments().size()));
+	for (const auto& segment : plan.getCorridorSegments())
+	{
+		transforms.Add(ARoom::getSegmentTransform(segment));
+	}
+	corridorBlocks->AddInstances(transforms, false);
+	RELICS_COUNT(InstancesAdded, transforms.Num());
+	if (corridorBlocks->GetInstanceCount() > 0)
+	{
+		dirtyNavigationAreas.Add(corridorBlocks->Bounds.GetBox());
+	}
 }
 
-void UpdateNavMeshBoundsVolume(UWorld* World, FVector Location, FVector Extent)
+void AGenerator::buildColliders(const FloorPlan& plan)
 {
-	if (!World) return;
-
-	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
-	if (!NavSys) return;
-
-	ANavMeshBoundsVolume* NavBoundsVolume = nullptr;
-
-	// Check for existing NavMeshBoundsVolume
-	for (TActorIterator<ANavMeshBoundsVolume> ActorItr(World); ActorItr; ++ActorItr)
+	unless(mergedWallCollision)
 	{
-		NavBoundsVolume = *ActorItr;
-		break;
+		return;
 	}
+	RELICS_SCOPE(BuildColliders);
 
-	if (!NavBoundsVolume)
+	//boxes go to the chunk their corner lies in, a box crossing into the next chunk stays whole
+	TMap<FIntPoint, TArray<FBox>> chunks;
+	for (const auto& segment : plan.getColliders())
 	{
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Owner = nullptr;
-		SpawnParams.Instigator = nullptr;
-		NavBoundsVolume = World->SpawnActor<ANavMeshBoundsVolume>(Location, FRotator::ZeroRotator, SpawnParams);
+		FIntPoint chunk(0, 0);
+		if (collisionChunkCells > 0)
+		{
+			chunk = FIntPoint(FMath::FloorToInt(segment.r / collisionChunkCells),
+			                  FMath::FloorToInt(segment.c / collisionChunkCells));
+		}
+		const FVector min(segment.r * 100.f, segment.c * 100.f, segment.alt * 100.f);
+		const FVector extent(segment.rScale * 100.f, segment.cScale * 100.f, segment.zScale * 100.f);
+		chunks.FindOrAdd(chunk).Add(FBox(min, min + extent));
 	}
 
-	if (NavBoundsVolume)
+	for (const auto& chunk : chunks)
 	{
-		NavBoundsVolume->SetActorLocation(Location);
+		//rooms are spawned in world space at row * 100, so the boxes stay there too wherever the generator stands
+		UDungeonCollisionComponent* collider = NewObject<UDungeonCollisionComponent>(this);
+		collider->SetupAttachment(GetRootComponent());
+		collider->SetAbsolute(true, true, true);
+		collider->RegisterComponent();
+		collider->setBoxes(chunk.Value);
+		wallColliders.Add(collider);
+	}
+}
 
-		UBrushComponent* Brush = NavBoundsVolume->GetBrushComponent();
-		if (Brush)
+void AGenerator::buildProps(const FloorPlan& plan)
+{
+	RELICS_SCOPE(BuildProps);
+	for (int32 kind = 0; kind < FMath::Min(propMeshes.Num(), PROP_KIND_COUNT); kind++)
+	{
+		const std::vector<PropInstance>& props = plan.getProps(static_cast<PropKind>(kind));
+		if (!propMeshes[kind] || props.empty())
 		{
-			// Set mobility so the bounds can be updated at runtime
-			Brush->SetMobility(EComponentMobility::Movable);
+			continue;
+		}
 
-			// Set box extent — this is what actually defines the nav area
-			//Brush->SetBoxExtent(Extent); DOESN'T EXIXST LOL
-			Brush->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		TArray<FTransform> transforms;
+		transforms.Reserve(static_cast<int32>(props.size()));
+		for (const PropInstance& prop : props)
+		{
+			const FVector location(prop.r * 100.f, prop.c * 100.f, 0.f);
+			transforms.Add(FTransform(FRotator(0.f, prop.yaw, 0.f), location));
 		}
 
-		// Notify the nav system of bounds update
-		NavSys->OnNavigationBoundsUpdated(NavBoundsVolume);
+		UInstancedStaticMeshComponent* instances = NewObject<UInstancedStaticMeshComponent>(this);
+		instances->SetupAttachment(GetRootComponent());
+		instances->SetStaticMesh(propMeshes[kind]);
+		instances->RegisterComponent();
+		instances->AddInstances(transforms, false);
+		RELICS_COUNT(InstancesAdded, transforms.Num());
+		dirtyNavigationAreas.Add(instances->Bounds.GetBox());
+		propInstances.Add(instances);
 	}
 }
 
-// Example usage (e.g., in an Actor's BeginPlay or a custom function)
-void AGenerator::buildNavMesh()
+void AGenerator::buildBasePlate()
 {
-	FVector NavLocation = FVector(size / 2.f * 100.f, size / 2.f * 100.f, 250.f);
-	FVector NavExtent = FVector(size / 2.f * 100.f, size / 2.f * 100.f, 250.0f);
+	FMatrix transformMatrix = FMatrix(
+		FPlane(size * 1.0f, 0.0f, 0.0f, 0.0f),
+		FPlane(0.0f, size * 1.0f, 0.0f, 0.0f),
+		FPlane(0.0f, 0.0f, 1.0f, 0.0f),
+		FPlane(0.0f, 0.0f, -100.0f, 1.0f)
+	);
+	const FTransform plate(transformMatrix);
+
+	//re-adding an identical plate would dirty the nav tiles of the whole dungeon
+	FTransform current;
+	if (blocks->GetInstanceCount() == 1 && blocks->GetInstanceTransform(0, current) && current.Equals(plate))
+	{
+		return;
+	}
 
-	UpdateNavMeshBoundsVolume(GetWorld(), NavLocation, NavExtent);
+	blocks->ClearInstances();
+	blocks->AddInstance(plate);
+}
+
+FBox AGenerator::getDungeonBounds() const
+{
+	//one cell of margin for the overheads that hang outside a room's footprint
+	const float extent = (size + 2) * 100.f;
+	return FBox(FVector(-100.f, -100.f, -100.f), FVector(extent - 100.f, extent - 100.f, 800.f));
 }
 
-/*
 void AGenerator::buildNavMesh()
 {
-	UWorld* World = GetWorld();
-	if (World)
-	{
-		//spawns the navmesh in the center of the dungeon
-		FVector spawnLoc = FVector(size / 2.f * 100.f, size / 2.f * 100.f, 0.f);
-		FActorSpawnParameters spawnParams;
-		spawnParams.OverrideLevel = GetLevel();
-		
-		navMesh = World->SpawnActor<ANavMeshBoundsVolume>(
-			ANavMeshBoundsVolume::StaticClass(),
-			spawnLoc,
-			FRotator::ZeroRotator,
-			spawnParams
-		);
-
-		if (navMesh)
-		{
-			// Create the BoxComponent
-			UBoxComponent* BoxComp = NewObject<UBoxComponent>(navMesh);
-			if (BoxComp)
-			{
-				BoxComp->RegisterComponent();
-				//accepts a radius, not a diameter, so divide all values by 2
-				BoxComp->SetBoxExtent(FVector(size * 100.f / 2.f, size * 100.f / 2.f, 1000.f));
-				BoxComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-				BoxComp->SetWorldLocation(navMesh->GetActorLocation());
-
-				// Attach to actor
-				BoxComp->AttachToComponent(navMesh->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-
-				// Tell nav system about it
-				UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
-				if (NavSys)
-				{
-					NavSys->OnNavigationBoundsUpdated(navMesh);
-				}
-			}
+	UWorld* world = GetWorld();
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	if (!navSys)
+	{
+		return;
+	}
+
+	if (!navMesh)
+	{
+		for (TActorIterator<ANavMeshBoundsVolume> actorItr(world); actorItr; ++actorItr)
+		{
+			navMesh = *actorItr;
+			break;
 		}
 	}
+
+	UBrushComponent* brush = navMesh ? navMesh->GetBrushComponent() : nullptr;
+	if (!brush || !brush->Brush)
+	{
+		//a volume spawned at runtime has no brush geometry, so there is nothing to scale
+		UE_LOG(LogTemp, Error, TEXT("AGenerator needs a NavMeshBoundsVolume placed in the level"));
+		return;
+	}
+
+	//the brush extent cannot be changed at runtime, so the actor is scaled to fit the dungeon instead
+	const FBox bounds = getDungeonBounds();
+	const FVector brushExtent = brush->Brush->Bounds.BoxExtent;
+	const FVector scale = bounds.GetExtent() / brushExtent.ComponentMax(FVector(1.f));
+
+	if (navMesh->GetActorLocation().Equals(bounds.GetCenter()) && navMesh->GetActorScale3D().Equals(scale))
+	{
+		return;
+	}
+
+	brush->SetMobility(EComponentMobility::Movable);
+	brush->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	navMesh->SetActorLocationAndRotation(bounds.GetCenter(), FRotator::ZeroRotator);
+	navMesh->SetActorScale3D(scale);
+
+	navSys->OnNavigationBoundsUpdated(navMesh);
 }
-*/
 
 void AGenerator::init(int32 tSize, int32 tRoom_min, int32 tRoom_max, int32 tGap, int32 tSeed)
 {
@@ -130,10 +186,10 @@ void AGenerator::init(int32 tSize, int32 tRoom_min, int32 tRoom_max, int32 tGap,
 	seed = tSeed;
 }
 
-ARoom* AGenerator::build(UWorld* world, RandomGenerator& rg, const RoomImpl& room)
+ARoom* AGenerator::build(UWorld* world, const RoomPlan& room, const int32 index)
 {
-	unsigned int row = room.getRow();
-	unsigned int col = room.getCol();
+	unsigned int row = room.room.getRow();
+	unsigned int col = room.room.getCol();
 	FVector spawnLocation(row * 100.f, col * 100.f, 0.f);
 	FTransform spawnTransform(spawnLocation);
 	FActorSpawnParameters spawnParams;
@@ -155,7 +211,13 @@ ARoom* AGenerator::build(UWorld* world, RandomGenerator& rg, const RoomImpl& roo
 
 	if (spawnedRoom)
 	{
-		spawnedRoom->init(room, rg, enemy, chest, exit);
+		//the merged bodies from buildColliders stand in for the cubes, which then only render
+		if (mergedWallCollision)
+		{
+			spawnedRoom->blocks->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+		spawnedRoom->init(room, index, floorDelta, enemy, chest, exit, HasAuthority(), crowd.Get());
+		RELICS_COUNT(RoomsSpawned, 1);
 
 		//UGameplayStatics::FinishSpawningActor(spawnedRoom, spawnTransform);											No longer needed because SpawnActorDeferred is no longer being used
 		return spawnedRoom;
@@ -166,21 +228,87 @@ ARoom* AGenerator::build(UWorld* world, RandomGenerator& rg, const RoomImpl& roo
 }
 
 
-void AGenerator::delayedBuildNavigation()
+void AGenerator::rebuildNavigation()
+{
+	RELICS_SCOPE(RebuildNavigation);
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (!navSys)
+	{
+		dirtyNavigationAreas.Reset();
+		onNavigationReady.Broadcast();
+		return;
+	}
+
+	for (ARoom* room : rooms)
+	{
+		if (room)
+		{
+			dirtyNavigationAreas.Add(room->GetComponentsBoundingBox(true));
+		}
+	}
+
+	//only tiles under rooms that were removed or added are rebuilt, the rest of the level keeps its nav data
+	for (const FBox& area : dirtyNavigationAreas)
+	{
+		if (area.IsValid)
+		{
+			navSys->AddDirtyArea(area.ExpandBy(100.f), ENavigationDirtyFlag::All);
+		}
+	}
+	dirtyNavigationAreas.Reset();
+
+	navSys->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(this, &AGenerator::onNavigationGenerationFinished);
+	awaitingNavigation = true;
+
+	//dirty areas are handed to the nav generator on its next tick
+	GetWorldTimerManager().SetTimerForNextTick(this, &AGenerator::checkNavigationReady);
+}
+
+void AGenerator::checkNavigationReady()
 {
-	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
-	if (NavSys)
+	if (!awaitingNavigation)
+	{
+		return;
+	}
+
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (navSys && (navSys->HasDirtyAreasQueued() || navSys->IsNavigationBuildInProgress()))
 	{
-		NavSys->Build();
+		return;
 	}
+
+	awaitingNavigation = false;
+	onNavigationReady.Broadcast();
+}
+
+void AGenerator::onNavigationGenerationFinished(ANavigationData* navData)
+{
+	checkNavigationReady();
+}
+
+bool AGenerator::isNavigationReady() const
+{
+	return !awaitingNavigation;
 }
 
 AGenerator::AGenerator()
-	: size(32), room_min(5), room_max(5), gap(3), seed(0), navMesh(nullptr)
+	: awaitingNavigation(false), nextFloorBoundary(EDungeonBoundary::Circle), lastCameraCell(-1, -1), lastCameraYaw(0.f),
+	  lastMinimapRoom(-1),
+	  size(32), room_min(5), room_max(5), gap(3), seed(0), boundary(EDungeonBoundary::Circle), boundaryImage(nullptr),
+	  logGeneration(false), nextFloorMemoryCapMB(64), portalCulling(true), portalCullDistance(96.f),
+	  generationBudgetMs(0.f), generationSliceMs(0.f), enemyDormancy(true), dormancyHops(2), enemyProxies(false), mergedWallCollision(false),
+	  collisionChunkCells(0), minimapResolution(512), minimapRevealRadius(4), fogOfWar(true),
+	  sightRadius(24), minimap(nullptr), navMesh(nullptr)
 
 {
 	UE_LOG(LogTemp, Log, TEXT("Constructor called"));
-	PrimaryActorTick.bCanEverTick = false;
+	//only ticks while portal culling has a floor to work on
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	//the floor goes over the network as its descriptor, see onRepDungeon
+	bReplicates = true;
+	bAlwaysRelevant = true;
 
 	USceneComponent* SceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("SceneComponent"));
 	SetRootComponent(SceneComponent);
@@ -188,10 +316,20 @@ AGenerator::AGenerator()
 	blocks = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Walls"));
 	blocks->SetupAttachment(SceneComponent);
 
+	corridorBlocks = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Corridors"));
+	corridorBlocks->SetupAttachment(SceneComponent);
+
+	enemyProxyMeshes = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("EnemyProxies"));
+	enemyProxyMeshes->SetupAttachment(SceneComponent);
+	enemyProxyMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	enemyProxyMeshes->SetCanEverAffectNavigation(false);
+
 	static ConstructorHelpers::FObjectFinder<UStaticMesh> cubeMesh(TEXT("/Game/LevelPrototyping/Meshes/SM_Cube"));
 	if (cubeMesh.Succeeded())
 	{
 		blocks->SetStaticMesh(cubeMesh.Object);
+		corridorBlocks->SetStaticMesh(cubeMesh.Object);
+		enemyProxyMeshes->SetStaticMesh(cubeMesh.Object);
 	}
 	else
 	{
@@ -236,83 +374,1170 @@ AGenerator::~AGenerator()
 
 void AGenerator::buildDungeon()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Pre-Gen-GetWorld"));
-	UWorld* world = GetWorld();
-	UE_LOG(LogTemp, Warning, TEXT("Post-Gen-GetWorld"));
-
-	clearDungeon();
+	unless(HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Clients rebuild the floor the server replicates instead of generating their own"));
+		return;
+	}
+	RELICS_SCOPE(BuildDungeon);
 
-	buildBasePlate();
+	cancelNextFloor();
+	steppedFloor.Reset();
 
 	if (!seed)
 	{
 		seed = RandomGenerator().getRandom();
 	}
 
-	GeneratorImpl generator(size, room_min, room_max, gap, seed);
-	generator.generate();
+	TSharedPtr<FloorPlan> plan = MakeShared<FloorPlan>(size, room_min, room_max, gap, seed);
+	plan->setBoundary(makeBoundary(boundary, size, seed));
+	if (generationSliceMs > 0.f)
+	{
+		slicedFloor = plan;
+		SetActorTickEnabled(true);
+		return;
+	}
+	slicedFloor.Reset();
+	GenerationLog log;
+	GenerationBudget budget;
+	budget.milliseconds = generationBudgetMs;
+	GenerationReport report;
+	{
+		RELICS_SCOPE(Generate);
+		report = plan->generate(budget, logGeneration ? &log : nullptr);
+	}
+	if (report.status == GenerationStatus::Partial)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Floor %d ran out of its %.1f ms budget with %d rooms covering %.0f%% of the floor"),
+		       seed, generationBudgetMs, report.rooms, report.coverage * 100.f);
+	}
 
-	for (auto room : generator.getRooms())
+	if (logGeneration)
 	{
-		rooms.push_back(build(world, generator.getRandomGenerator(), room));
+		const FString path = FPaths::ProjectSavedDir() / TEXT("GenerationLogs") / FString::Printf(TEXT("seed_%d.rgl"), seed);
+		const std::vector<uint8_t>& bytes = log.getBytes();
+		unless(FFileHelper::SaveArrayToFile(TArrayView<const uint8>(bytes.data(), static_cast<int32>(bytes.size())), *path))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not write generation log %s"), *path);
+		}
 	}
-	//buildNavMesh();
-	FTimerHandle TimerHandle;
-	GetWorld()->GetTimerManager().SetTimer(TimerHandle, this, &AGenerator::delayedBuildNavigation, 1.f, false);  
+
+	buildFloor(plan, boundary);
 }
 
-void AGenerator::BeginDestroy()
+std::shared_ptr<const BoundaryMask> AGenerator::makeBoundary(const EDungeonBoundary shape, const int32 floorSize,
+                                                             const int32 floorSeed) const
 {
-	UE_LOG(LogTemp, Warning, TEXT("begin destroy called"));
+	switch (shape)
+	{
+	case EDungeonBoundary::Island:
+		return BoundaryMask::make(BoundaryShape::Island, floorSize, static_cast<unsigned int>(floorSeed));
+	case EDungeonBoundary::Cave:
+		return BoundaryMask::make(BoundaryShape::Cave, floorSize, static_cast<unsigned int>(floorSeed));
+	case EDungeonBoundary::Image:
+		break;
+	default:
+		return nullptr;
+	}
 
-	clearDungeon();
-	Super::BeginDestroy();
+	const FTexturePlatformData* platformData = boundaryImage ? boundaryImage->GetPlatformData() : nullptr;
+	const EPixelFormat format = boundaryImage ? boundaryImage->GetPixelFormat() : PF_Unknown;
+	if (!platformData || platformData->Mips.IsEmpty() || (format != PF_G8 && format != PF_B8G8R8A8))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Boundary image is missing or not uncompressed G8 or BGRA8, using the circle"));
+		return nullptr;
+	}
+
+	const FTexture2DMipMap& mip = platformData->Mips[0];
+	const int32 width = mip.SizeX;
+	const int32 height = mip.SizeY;
+	const int32 stride = format == PF_G8 ? 1 : 4;
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+	const uint8* data = static_cast<const uint8*>(mip.BulkData.LockReadOnly());
+	if (data)
+	{
+		//the red channel of BGRA, which is as good as any for a grayscale image
+		for (size_t i = 0; i < pixels.size(); i++)
+		{
+			pixels[i] = data[i * stride + (stride == 4 ? 2 : 0)];
+		}
+	}
+	mip.BulkData.Unlock();
+	unless(data)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not read the boundary image, using the circle"));
+		return nullptr;
+	}
+	return std::make_shared<ImageMask>(width, height, std::move(pixels));
 }
 
-void AGenerator::clearDungeon()
+void AGenerator::buildFloor(const TSharedPtr<FloorPlan>& plan, const EDungeonBoundary shape,
+                            const TArray<uint8>* savedDelta)
 {
-	UE_LOG(LogTemp, Warning, TEXT("clearDungeon called"));
+	RELICS_SCOPE(BuildFloor);
+	UWorld* world = GetWorld();
+	//a floor still being laid out on the game thread is given up for this one
+	if (slicedFloor != plan)
+	{
+		slicedFloor.Reset();
+	}
+	if (steppedFloor != plan)
+	{
+		steppedFloor.Reset();
+	}
 
-	TArray<AActor*> foundRoomActors;
+	activity.Reset();
+	crowd.Reset();
+	clearDungeon();
 
-	UE_LOG(LogTemp, Warning, TEXT("Pre-Gen-ClearDungeon-GetWorld"));
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ARoom::StaticClass(), foundRoomActors);
-	UE_LOG(LogTemp, Warning, TEXT("Post-Gen-ClearDungeon-GetWorld"));
+	size = plan->getSize();
+	room_min = plan->getRoomMin();
+	room_max = plan->getRoomMax();
+	gap = plan->getGap();
+	seed = static_cast<int32>(plan->getSeed());
+	boundary = shape;
+	portals.Reset();
+	//the field of view reads the old floor's walls, so it goes before them
+	fieldOfView.Reset();
+	lineOfSight.Reset();
+	pathfinder.Reset();
+	currentFloor = plan;
 
-	for (auto actor : foundRoomActors)
+	buildBasePlate();
+	if (enemyProxies)
+	{
+		crowd = MakeUnique<EnemyCrowd>(plan->getGraph(), plan->getSeed());
+	}
+
+	//a loaded floor's delta is applied while spawning, so used-up slots are never created in the first place
+	floorDelta = FloorDelta(*plan);
+	const TArray<uint8>* delta = HasAuthority() ? savedDelta : &floorDeltaBytes;
+	if (delta && !floorDelta.setBytes(delta->GetData(), delta->Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Floor delta of %d bytes does not fit this floor, ignoring it"), delta->Num());
+	}
+
+	for (const auto& room : plan->getRooms())
+	{
+		rooms.push_back(build(world, room, static_cast<int32>(rooms.size())));
+	}
+	RELICS_GAUGE(Rooms, rooms.size());
+	buildCorridors(*plan);
+	buildProps(*plan);
+	buildColliders(*plan);
+	buildNavMesh();
+	rebuildNavigation();
+
+	portals = MakeUnique<PortalVisibility>(plan->getGraph(), portalCullDistance);
+	shownRooms.assign(rooms.size(), 1);
+	lastCameraCell = FIntPoint(-1, -1);
+	startMinimap(plan);
+	exploredRooms.assign(rooms.size(), 0);
+	roomCellsInSight.assign(rooms.size(), 0);
+	lineOfSight = MakeUnique<LineOfSight>(plan->getWalls());
+	pathfinder = MakeUnique<RoomPathfinder>(plan->getPaths());
+	//sight only feeds the minimap and what is drawn, which a dedicated server has neither of
+	const bool seen = GetNetMode() != NM_DedicatedServer;
+	if (fogOfWar && seen)
+	{
+		fieldOfView = MakeUnique<FieldOfView>(plan->getWalls(), sightRadius);
+	}
+
+	unless(HasAuthority())
+	{
+		//the slots may have arrived before the floor they describe
+		bindSlots();
+		syncEnemyProxies();
+		SetActorTickEnabled(portalCulling || crowd.IsValid() || minimapResolution > 0 || fogOfWar);
+		return;
+	}
+
+	dungeon.seed = seed;
+	dungeon.size = size;
+	dungeon.room_min = room_min;
+	dungeon.room_max = room_max;
+	dungeon.gap = gap;
+	dungeon.version = GeneratorImpl::VERSION;
+	dungeon.boundary = boundary;
+	dungeon.attempts = plan->getReport().status == GenerationStatus::Partial ? plan->getReport().attempts : 0;
+
+	const std::vector<uint8_t>& bytes = floorDelta.getBytes();
+	floorDeltaBytes = TArray<uint8>(bytes.data(), static_cast<int32>(bytes.size()));
+
+	slots.Reset();
+	activity = MakeUnique<EnemyActivity>(plan->getGraph(), dormancyHops);
+	for (size_t i = 0; i < rooms.size(); i++)
+	{
+		if (!rooms[i])
+		{
+			continue;
+		}
+		//chests and exits share the room's spawn list
+		const std::vector<AActor*>& spawned = rooms[i]->enemies;
+		for (size_t j = 0; j < spawned.size(); j++)
+		{
+			if (!IsValid(spawned[j]))
+			{
+				continue;
+			}
+			slots.Add({static_cast<uint16>(i), static_cast<uint16>(j), spawned[j]});
+			if (enemy && spawned[j]->IsA(enemy))
+			{
+				activity->add(spawned[j]);
+			}
+		}
+	}
+	ForceNetUpdate();
+	SetActorTickEnabled(portalCulling || enemyDormancy || crowd.IsValid() || (seen && (minimapResolution > 0 || fogOfWar)));
+}
+
+void AGenerator::bindSlots()
+{
+	//slots come and go as the server turns enemies into proxies and back, so stale bindings are dropped first
+	for (ARoom* room : rooms)
 	{
-		ARoom* room = Cast<ARoom>(actor);
 		if (room)
 		{
-			room->clearActors();
+			room->enemies.assign(room->enemies.size(), nullptr);
 		}
-		actor->Destroy();
 	}
-	rooms.clear();
+	for (const FDungeonSlot& binding : slots)
+	{
+		if (binding.room < rooms.size() && rooms[binding.room])
+		{
+			rooms[binding.room]->bindActor(binding.slot, binding.actor);
+		}
+	}
+}
 
-	TArray<AActor*> foundEnemyActors;
+void AGenerator::onRepDungeon()
+{
+	if (dungeon.version != GeneratorImpl::VERSION)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Server generator version %d does not match ours (%d), cannot rebuild its floor"),
+		       dungeon.version, GeneratorImpl::VERSION);
+		return;
+	}
+	if (currentFloor.IsValid() && currentFloor->getSeed() == static_cast<unsigned int>(dungeon.seed)
+		&& currentFloor->getSize() == dungeon.size && currentFloor->getRoomMin() == dungeon.room_min
+		&& currentFloor->getRoomMax() == dungeon.room_max && currentFloor->getGap() == dungeon.gap
+		&& boundary == dungeon.boundary
+		&& (currentFloor->getReport().status == GenerationStatus::Partial ? currentFloor->getReport().attempts : 0)
+		== dungeon.attempts)
+	{
+		return;
+	}
 
-	UE_LOG(LogTemp, Warning, TEXT("Post-Gen-ClearDungeon-2-GetWorld"));
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), enemy, foundEnemyActors);
-	UE_LOG(LogTemp, Warning, TEXT("Post-Gen-ClearDungeon-2-GetWorld"));
+	//a floor the server cut short is replayed for the same number of attempts rather than the same time
+	TSharedPtr<FloorPlan> plan = MakeShared<FloorPlan>(dungeon.size, dungeon.room_min, dungeon.room_max, dungeon.gap,
+	                                                   dungeon.seed);
+	plan->setBoundary(makeBoundary(dungeon.boundary, dungeon.size, dungeon.seed));
+	GenerationBudget budget;
+	budget.attempts = dungeon.attempts;
+	plan->generate(budget);
+	buildFloor(plan, dungeon.boundary);
+}
 
-	for (auto enemyActor : foundEnemyActors)
+void AGenerator::onRepFloorDelta()
+{
+	if (floorDelta.setBytes(floorDeltaBytes.GetData(), floorDeltaBytes.Num()))
+	{
+		syncEnemyProxies();
+		onFloorDeltaChanged.Broadcast();
+	}
+}
+
+void AGenerator::onRepSlots()
+{
+	bindSlots();
+	syncEnemyProxies();
+}
+
+void AGenerator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AGenerator, dungeon);
+	DOREPLIFETIME(AGenerator, floorDeltaBytes);
+	DOREPLIFETIME(AGenerator, slots);
+}
+
+bool AGenerator::findSlot(AActor* actor, int32& room, int32& slot) const
+{
+	for (const FDungeonSlot& binding : slots)
 	{
-		if (enemyActor)
+		if (actor && binding.actor == actor)
 		{
-			enemyActor->Destroy();
+			room = binding.room;
+			slot = binding.slot;
+			return true;
 		}
 	}
+	room = -1;
+	slot = -1;
+	return false;
+}
 
-	if (navMesh)
+void AGenerator::consumeSlot(AActor* actor)
+{
+	int32 room;
+	int32 slot;
+	unless(HasAuthority() && findSlot(actor, room, slot))
+	{
+		return;
+	}
+	if (floorDelta.test(room, slot))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Attempted to delete navMesh actor"));
+		return;
+	}
+	floorDelta.set(room, slot);
+	const int index = floorDelta.toIndex(room, slot);
+	floorDeltaBytes[index / 8] = floorDelta.getBytes()[index / 8];
+	onFloorDeltaChanged.Broadcast();
+}
 
-		navMesh->Destroy();
-		navMesh = nullptr;
+UDungeonSaveGame* AGenerator::captureDungeon() const
+{
+	unless(currentFloor.IsValid())
+	{
+		return nullptr;
 	}
-	else
+	UDungeonSaveGame* save = Cast<UDungeonSaveGame>(UGameplayStatics::CreateSaveGameObject(UDungeonSaveGame::StaticClass()));
+	save->dungeon = dungeon;
+	const std::vector<uint8_t>& bytes = floorDelta.getBytes();
+	save->delta = TArray<uint8>(bytes.data(), static_cast<int32>(bytes.size()));
+	return save;
+}
+
+bool AGenerator::restoreDungeon(const UDungeonSaveGame* save)
+{
+	unless(save && HasAuthority())
+	{
+		return false;
+	}
+	if (save->dungeon.version != GeneratorImpl::VERSION)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Save was made by generator version %d, this is version %d"), save->dungeon.version,
+		       GeneratorImpl::VERSION);
+		return false;
+	}
+
+	cancelNextFloor();
+	TSharedPtr<FloorPlan> plan = MakeShared<FloorPlan>(save->dungeon.size, save->dungeon.room_min,
+	                                                   save->dungeon.room_max, save->dungeon.gap, save->dungeon.seed);
+	plan->setBoundary(makeBoundary(save->dungeon.boundary, save->dungeon.size, save->dungeon.seed));
+	GenerationBudget budget;
+	budget.attempts = save->dungeon.attempts;
+	plan->generate(budget);
+	buildFloor(plan, save->dungeon.boundary, &save->delta);
+	return true;
+}
+
+bool AGenerator::saveDungeon(const FString& slotName, const int32 userIndex) const
+{
+	UDungeonSaveGame* save = captureDungeon();
+	return save && UGameplayStatics::SaveGameToSlot(save, slotName, userIndex);
+}
+
+bool AGenerator::loadDungeon(const FString& slotName, const int32 userIndex)
+{
+	return restoreDungeon(Cast<UDungeonSaveGame>(UGameplayStatics::LoadGameFromSlot(slotName, userIndex)));
+}
+
+float AGenerator::getFloorCoverage() const
+{
+	return currentFloor.IsValid() ? currentFloor->getReport().coverage : 0.f;
+}
+
+bool AGenerator::isSlotConsumed(const int32 room, const int32 slot) const
+{
+	return floorDelta.test(room, slot);
+}
+
+void AGenerator::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	updateSlicedGeneration();
+	if (portalCulling)
+	{
+		updatePortalCulling();
+	}
+	updateEnemyActivity(DeltaTime);
+	updateMinimap();
+	updateFieldOfView();
+	updateLineOfSight();
+	if (minimapRaster.IsValid() && minimap)
+	{
+		uploadMinimap();
+	}
+}
+
+void AGenerator::updateSlicedGeneration()
+{
+	unless(slicedFloor.IsValid())
+	{
+		return;
+	}
+	GenerationBudget budget;
+	budget.milliseconds = generationSliceMs;
+	GenerationReport report;
+	{
+		RELICS_SCOPE(Generate);
+		report = slicedFloor->resume(budget);
+	}
+	if (report.status == GenerationStatus::Partial)
+	{
+		return;
+	}
+	const TSharedPtr<FloorPlan> plan = slicedFloor;
+	slicedFloor.Reset();
+	buildFloor(plan, boundary);
+}
+
+void AGenerator::stepGeneration()
+{
+	unless(HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Clients rebuild the floor the server replicates instead of generating their own"));
+		return;
+	}
+	unless(steppedFloor.IsValid())
+	{
+		cancelNextFloor();
+		slicedFloor.Reset();
+		if (!seed)
+		{
+			seed = RandomGenerator().getRandom();
+		}
+		steppedFloor = MakeShared<FloorPlan>(size, room_min, room_max, gap, seed);
+		steppedFloor->setBoundary(makeBoundary(boundary, size, seed));
+	}
+
+	static const TCHAR* stepNames[] = {
+		TEXT("start"), TEXT("attempt"), TEXT("placed"), TEXT("reshaped"), TEXT("doors"), TEXT("done")
+	};
+	//a minimap task may still be reading the floor it was started for, which must not change under it
+	if (minimapTask.IsValid())
+	{
+		minimapTask.Wait();
+	}
+	const GenerationStep step = steppedFloor->step();
+	UE_LOG(LogTemp, Display, TEXT("Floor %d stepped to %s with %d rooms"), seed, stepNames[static_cast<int32>(step)],
+	       steppedFloor->getReport().rooms);
+	unless(step == GenerationStep::Done)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Could not find navMesh actor"));
+		showSteppedRooms(*steppedFloor);
+		return;
+	}
+	const TSharedPtr<FloorPlan> plan = steppedFloor;
+	steppedFloor.Reset();
+	buildFloor(plan, boundary);
+}
+
+void AGenerator::showSteppedRooms(const FloorPlan& plan)
+{
+	//the floor before is given up, but a half laid out one only ever exists here, it is neither replicated nor
+	//handed to culling, the minimap, sight or enemies until its last step builds it for real
+	activity.Reset();
+	crowd.Reset();
+	portals.Reset();
+	fieldOfView.Reset();
+	lineOfSight.Reset();
+	pathfinder.Reset();
+	minimapTask.Reset();
+	minimapRaster.Reset();
+	currentFloor.Reset();
+	clearDungeon();
+	for (const auto& room : plan.getRooms())
+	{
+		rooms.push_back(build(GetWorld(), room, static_cast<int32>(rooms.size())));
+	}
+	RELICS_GAUGE(Rooms, rooms.size());
+}
+
+void AGenerator::getPlayerLocations(TArray<FVector>& out) const
+{
+	out.Reset();
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		const APlayerController* controller = it->Get();
+		if (const APawn* pawn = controller ? controller->GetPawn() : nullptr)
+		{
+			out.Add(pawn->GetActorLocation());
+		}
+	}
+}
+
+void AGenerator::updateEnemyActivity(const float seconds)
+{
+	//a client's proxies wander on their own, the server only says which enemies are proxies at all
+	if (crowd.IsValid() && !HasAuthority())
+	{
+		crowd->step(seconds);
+		drawEnemyProxies();
+		return;
+	}
+	if (!activity.IsValid())
+	{
+		return;
+	}
+	RELICS_SCOPE(EnemyActivity);
+	//a dedicated server has no player of its own, every connected one keeps the rooms around them awake
+	TArray<FVector> players;
+	getPlayerLocations(players);
+	if (crowd.IsValid())
+	{
+		updateEnemyProxies(players, seconds);
+		RELICS_GAUGE(EnemyProxies, crowd->getCount());
+		return;
+	}
+	unless(enemyDormancy)
+	{
+		activity->wakeAll();
+		return;
+	}
+	activity->update(players);
+	RELICS_GAUGE(DormantEnemies, activity->getDormantCount());
+}
+
+void AGenerator::updateEnemyProxies(const TArray<FVector>& players, const float seconds)
+{
+	TArray<AActor*> leaving;
+	activity->update(players, &leaving);
+	for (AActor* actor : leaving)
+	{
+		demoteEnemy(actor);
+	}
+	//promoting swaps the last proxy into the freed index, walking backwards never skips one
+	for (int i = crowd->getCount() - 1; i >= 0; i--)
+	{
+		if (activity->isNear(crowd->getRoom(i)))
+		{
+			promoteEnemy(i);
+		}
+	}
+	crowd->step(seconds);
+	drawEnemyProxies();
+}
+
+void AGenerator::demoteEnemy(AActor* actor)
+{
+	int32 room;
+	int32 slot;
+	unless(findSlot(actor, room, slot) && room < static_cast<int32>(rooms.size()) && rooms[room])
+	{
+		//not one of the floor's own enemies, it is left as it is
+		activity->add(actor);
+		return;
+	}
+	//the enemy's SaveGame properties, health and aggro and the like, go along with the proxy and back onto the actor
+	TArray<uint8> bytes;
+	FMemoryWriter writer(bytes, true);
+	FObjectAndNameAsStringProxyArchive archive(writer, true);
+	archive.ArIsSaveGame = true;
+	actor->Serialize(archive);
+	const FVector location = actor->GetActorLocation();
+	crowd->add(room, slot, location.X / 100.f, location.Y / 100.f, actor->GetActorRotation().Yaw,
+	           std::vector<uint8_t>(bytes.GetData(), bytes.GetData() + bytes.Num()));
+	rooms[room]->bindActor(slot, nullptr);
+	slots.RemoveAll([actor](const FDungeonSlot& binding) { return binding.actor == actor; });
+	actor->Destroy();
+	RELICS_COUNT(ActorsDestroyed, 1);
+}
+
+void AGenerator::promoteEnemy(const int index)
+{
+	const int32 room = crowd->getRoom(index);
+	const int32 slot = crowd->getSlot(index);
+	const FVector location(crowd->getRow(index) * 100.f, crowd->getCol(index) * 100.f, 0.f);
+	const float yaw = crowd->getYaw(index);
+	const std::vector<uint8_t>& state = crowd->getState(index);
+	const TArray<uint8> bytes(state.data(), static_cast<int32>(state.size()));
+	crowd->remove(index);
+
+	if (room >= static_cast<int32>(rooms.size()) || !rooms[room])
+	{
+		return;
+	}
+	if (AActor* actor = rooms[room]->spawnEnemy(slot, location, yaw))
+	{
+		if (bytes.Num() > 0)
+		{
+			FMemoryReader reader(bytes, true);
+			FObjectAndNameAsStringProxyArchive archive(reader, true);
+			archive.ArIsSaveGame = true;
+			actor->Serialize(archive);
+		}
+		slots.Add({static_cast<uint16>(room), static_cast<uint16>(slot), actor});
+		activity->add(actor);
+	}
+}
+
+void AGenerator::drawEnemyProxies()
+{
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+	//the default cube scaled to about an enemy's size
+	const FVector scale(0.6f, 0.6f, 1.8f);
+	TArray<FTransform> transforms;
+	transforms.Reserve(crowd->getCount());
+	for (int i = 0; i < crowd->getCount(); i++)
+	{
+		const FVector location(crowd->getRow(i) * 100.f, crowd->getCol(i) * 100.f, 0.f);
+		transforms.Add(FTransform(FRotator(0.f, crowd->getYaw(i), 0.f), location, scale));
+	}
+	//moving every instance in place is far cheaper than rebuilding the buffer, which only happens when the count changes
+	if (enemyProxyMeshes->GetInstanceCount() == transforms.Num())
+	{
+		enemyProxyMeshes->BatchUpdateInstancesTransforms(0, transforms, true, true, true);
+		return;
+	}
+	enemyProxyMeshes->ClearInstances();
+	enemyProxyMeshes->AddInstances(transforms, false, true, false);
+	RELICS_COUNT(InstancesAdded, transforms.Num());
+}
+
+void AGenerator::syncEnemyProxies()
+{
+	if (!crowd.IsValid() || HasAuthority() || !currentFloor.IsValid())
+	{
+		return;
+	}
+	const std::vector<RoomPlan>& plans = currentFloor->getRooms();
+	const auto isProxy = [&](const int room, const int slot)
+	{
+		//a room without doors never sized its slots, the server spawned nothing there either
+		return room < static_cast<int>(rooms.size()) && room < static_cast<int>(plans.size()) && rooms[room]
+			&& slot < static_cast<int>(rooms[room]->enemies.size()) && plans[room].spawns[slot].kind == SpawnKind::Enemy
+			&& !floorDelta.test(room, slot) && !rooms[room]->enemies[slot];
+	};
+
+	//proxies the server has since promoted or seen killed go, the ones it has demoted come in at their spawn point
+	std::vector<unsigned char> held(floorDelta.getSlotCount(), 0);
+	for (int i = crowd->getCount() - 1; i >= 0; i--)
+	{
+		if (isProxy(crowd->getRoom(i), crowd->getSlot(i)))
+		{
+			held[floorDelta.toIndex(crowd->getRoom(i), crowd->getSlot(i))] = 1;
+		}
+		else
+		{
+			crowd->remove(i);
+		}
+	}
+	for (int room = 0; room < static_cast<int>(plans.size()); room++)
+	{
+		for (int slot = 0; slot < static_cast<int>(plans[room].spawns.size()); slot++)
+		{
+			if (isProxy(room, slot) && !held[floorDelta.toIndex(room, slot)])
+			{
+				const SpawnPoint& spawn = plans[room].spawns[slot];
+				const FVector location = rooms[room]->GetActorLocation();
+				crowd->add(room, slot, (location.X + spawn.x) / 100.f, (location.Y + spawn.y) / 100.f, 0.f);
+			}
+		}
+	}
+	drawEnemyProxies();
+}
+
+void AGenerator::startMinimap(const TSharedPtr<FloorPlan>& plan)
+{
+	minimapTask.Reset();
+	minimapRaster.Reset();
+	lastMinimapRoom = -1;
+	//nobody looks at a dedicated server's minimap
+	if (minimapResolution <= 0 || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+	//the task keeps the plan alive, so a floor replaced before it finishes is dropped along with it
+	minimapTask = Async(EAsyncExecution::ThreadPool, [plan, resolution = minimapResolution]
+	{
+		return TSharedPtr<MinimapRaster>(MakeShared<MinimapRaster>(*plan, resolution));
+	});
+}
+
+void AGenerator::updateMinimap()
+{
+	if (minimapTask.IsValid() && minimapTask.IsReady())
+	{
+		minimapRaster = minimapTask.Get();
+		minimapTask.Reset();
+		//the texture is kept from floor to floor while its size does not change
+		const int32 dimension = minimapRaster->getDimension();
+		if (!minimap || minimap->GetSizeX() != dimension || minimap->GetSizeY() != dimension)
+		{
+			minimap = UTexture2D::CreateTransient(dimension, dimension, PF_B8G8R8A8);
+			minimap->Filter = TF_Nearest;
+			minimap->SRGB = true;
+			minimap->UpdateResource();
+		}
+	}
+	if (!minimapRaster.IsValid() || !minimap || !currentFloor.IsValid())
+	{
+		return;
+	}
+	//the field of view reveals the minimap itself while there is one
+	if (fieldOfView.IsValid())
+	{
+		return;
+	}
+	RELICS_SCOPE(Minimap);
+
+	if (const APawn* player = UGameplayStatics::GetPlayerPawn(this, 0))
+	{
+		const FVector location = player->GetActorLocation();
+		const int32 r = FMath::FloorToInt(location.X / 100.f);
+		const int32 c = FMath::FloorToInt(location.Y / 100.f);
+		minimapRaster->reveal(r - minimapRevealRadius, c - minimapRevealRadius, r + minimapRevealRadius,
+		                      c + minimapRevealRadius);
+		//a room is shown whole as soon as it is walked into
+		const int32 room = getRoomAt(location);
+		if (room >= 0 && room != lastMinimapRoom)
+		{
+			const RoomBounds& bounds = currentFloor->getGraph().getBounds(room);
+			minimapRaster->reveal(bounds.row, bounds.col, bounds.row + bounds.height - 1, bounds.col + bounds.width - 1);
+		}
+		lastMinimapRoom = room;
+	}
+}
+
+void AGenerator::updateFieldOfView()
+{
+	//the minimap only hears about a cell the first time it is seen, so nothing is seen before it is drawn
+	if (!fieldOfView.IsValid() || !currentFloor.IsValid() || minimapTask.IsValid())
+	{
+		return;
+	}
+	const APawn* player = UGameplayStatics::GetPlayerPawn(this, 0);
+	unless(player)
+	{
+		return;
+	}
+	RELICS_SCOPE(FieldOfView);
+	const FVector location = player->GetActorLocation();
+	unless(fieldOfView->update(FMath::FloorToInt(location.X / 100.f), FMath::FloorToInt(location.Y / 100.f)))
+	{
+		return;
+	}
+
+	const RoomIdLayer& ids = currentFloor->getGraph().getRoomIds();
+	for (const CellSpan& span : fieldOfView->getDiscovered())
+	{
+		if (minimapRaster.IsValid())
+		{
+			minimapRaster->reveal(span.r, span.from, span.r, span.to - 1);
+		}
+	}
+	//only the cells that came into or went out of view are looked at, never the whole circle
+	for (const CellSpan& span : fieldOfView->getChanged())
+	{
+		for (int c = span.from; c < span.to; c++)
+		{
+			const int room = ids.get(span.r, c);
+			if (room < 0 || room >= static_cast<int>(roomCellsInSight.size()))
+			{
+				continue;
+			}
+			if (fieldOfView->isVisible(span.r, c))
+			{
+				roomCellsInSight[room]++;
+				exploredRooms[room] = 1;
+			}
+			else
+			{
+				roomCellsInSight[room]--;
+			}
+		}
+	}
+	RELICS_COUNT(FieldOfViewSpans, static_cast<int32>(fieldOfView->getChanged().size()));
+}
+
+bool AGenerator::isLocationVisible(const FVector location) const
+{
+	return !fieldOfView.IsValid()
+		|| fieldOfView->isVisible(FMath::FloorToInt(location.X / 100.f), FMath::FloorToInt(location.Y / 100.f));
+}
+
+bool AGenerator::isLocationExplored(const FVector location) const
+{
+	return !fieldOfView.IsValid()
+		|| fieldOfView->isExplored(FMath::FloorToInt(location.X / 100.f), FMath::FloorToInt(location.Y / 100.f));
+}
+
+bool AGenerator::isRoomExplored(const int32 room) const
+{
+	if (!fieldOfView.IsValid())
+	{
+		return true;
+	}
+	return room >= 0 && room < static_cast<int32>(exploredRooms.size()) && exploredRooms[room];
+}
+
+bool AGenerator::isRoomInSight(const int32 room) const
+{
+	if (!fieldOfView.IsValid())
+	{
+		return true;
+	}
+	return room >= 0 && room < static_cast<int32>(roomCellsInSight.size()) && roomCellsInSight[room] > 0;
+}
+
+void AGenerator::updateLineOfSight()
+{
+	if (!lineOfSight.IsValid() || lineOfSight->getPendingCount() == 0)
+	{
+		return;
+	}
+	RELICS_SCOPE(LineOfSight);
+	RELICS_COUNT(LineOfSightQueries, lineOfSight->getPendingCount());
+	lineOfSight->run();
+}
+
+int32 AGenerator::requestLineOfSight(const FVector from, const FVector to)
+{
+	unless(lineOfSight.IsValid())
+	{
+		return -1;
+	}
+	//the batch is run on tick, which may be off while nothing else needs it
+	unless(IsActorTickEnabled())
+	{
+		SetActorTickEnabled(true);
+	}
+	return lineOfSight->submit({
+		static_cast<float>(from.X / 100.f), static_cast<float>(from.Y / 100.f), static_cast<float>(to.X / 100.f),
+		static_cast<float>(to.Y / 100.f)
+	});
+}
+
+bool AGenerator::getLineOfSight(const int32 ticket, bool& clear) const
+{
+	clear = false;
+	return lineOfSight.IsValid() && lineOfSight->getResult(ticket, clear);
+}
+
+bool AGenerator::findRoomPath(const FVector from, const FVector to, TArray<FVector>& points, float& length)
+{
+	points.Reset();
+	length = 0.f;
+	unless(pathfinder.IsValid())
+	{
+		return false;
+	}
+	RELICS_SCOPE(RoomPaths);
+	RELICS_COUNT(RoomPathQueries, 1);
+	const int32 fromR = FMath::FloorToInt32(from.X / 100.f);
+	const int32 fromC = FMath::FloorToInt32(from.Y / 100.f);
+	const int32 toR = FMath::FloorToInt32(to.X / 100.f);
+	const int32 toC = FMath::FloorToInt32(to.Y / 100.f);
+	unless(pathfinder->find(fromR, fromC, toR, toC, lastPath))
+	{
+		return false;
+	}
+
+	//both ends keep their own height, the nav mesh settles everything in between onto the floor
+	const auto add = [&points](const int32 r, const int32 c, const double z)
+	{
+		points.Add(FVector((r + 0.5) * 100.0, (c + 0.5) * 100.0, z));
+	};
+	for (const auto& [r, c] : lastPath.head)
+	{
+		add(r, c, from.Z);
+	}
+	const RoomPaths& paths = currentFloor->getPaths();
+	for (size_t i = 1; i + 1 < lastPath.doors.size(); i++)
+	{
+		const int32 cell = paths.getPortalCell(lastPath.doors[i]);
+		add(cell / paths.getSize(), cell % paths.getSize(), from.Z);
+	}
+	//the tail starts on the last door, which the head already ends on when it is the only one
+	for (size_t i = lastPath.doors.size() > 1 ? 0 : 1; i < lastPath.tail.size(); i++)
+	{
+		add(lastPath.tail[i].first, lastPath.tail[i].second, to.Z);
+	}
+	points[0] = from;
+	points.Last() = to;
+	length = lastPath.length * 100.f;
+	return true;
+}
+
+void AGenerator::uploadMinimap()
+{
+	std::vector<MinimapRegion> dirty;
+	minimapRaster->takeDirty(dirty);
+	if (dirty.empty())
+	{
+		return;
+	}
+
+	//the regions are packed one under the other into a copy the render thread owns and frees
+	int32 pitch = 0;
+	int32 rows = 0;
+	for (const auto& region : dirty)
+	{
+		pitch = FMath::Max(pitch, region.width);
+		rows += region.height;
+	}
+	uint32* pixels = new uint32[static_cast<size_t>(pitch) * rows];
+	FUpdateTextureRegion2D* regions = new FUpdateTextureRegion2D[dirty.size()];
+	int32 offset = 0;
+	for (size_t i = 0; i < dirty.size(); i++)
+	{
+		const MinimapRegion& region = dirty[i];
+		minimapRaster->copyRegion(region, pixels + static_cast<size_t>(offset) * pitch, pitch);
+		regions[i] = FUpdateTextureRegion2D(region.x, region.y, 0, offset, region.width, region.height);
+		offset += region.height;
+	}
+	minimap->UpdateTextureRegions(0, static_cast<uint32>(dirty.size()), regions, pitch * sizeof(uint32), sizeof(uint32),
+	                              reinterpret_cast<uint8*>(pixels),
+	                              [](uint8* data, const FUpdateTextureRegion2D* used)
+	                              {
+		                              delete[] reinterpret_cast<uint32*>(data);
+		                              delete[] used;
+	                              });
+	RELICS_COUNT(MinimapRegions, static_cast<int32>(dirty.size()));
+}
+
+int32 AGenerator::getRoomAt(const FVector location) const
+{
+	unless(currentFloor.IsValid())
+	{
+		return -1;
+	}
+	return currentFloor->getGraph().findRoom(location.X / 100.f, location.Y / 100.f);
+}
+
+void AGenerator::updatePortalCulling()
+{
+	RELICS_SCOPE(PortalCulling);
+	APlayerCameraManager* cameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (!cameraManager || !portals.IsValid() || !currentFloor.IsValid())
+	{
+		return;
+	}
+
+	//rooms are spawned at row * 100 along X and col * 100 along Y, so yaw is already a grid angle
+	const FVector location = cameraManager->GetCameraLocation();
+	const float yaw = cameraManager->GetCameraRotation().Yaw;
+	const float r = location.X / 100.f;
+	const float c = location.Y / 100.f;
+	const FIntPoint cell(FMath::FloorToInt(r), FMath::FloorToInt(c));
+
+	if (cell != lastCameraCell || FMath::Abs(FRotator::NormalizeAxis(yaw - lastCameraYaw)) > 2.f)
+	{
+		lastCameraCell = cell;
+		lastCameraYaw = yaw;
+
+		//a little wider than the lens so turning does not pop rooms in before the next update
+		const float halfFov = FMath::DegreesToRadians(FMath::Min(cameraManager->GetFOVAngle() * 0.5f + 10.f, 180.f));
+		portals->computeVisible(r, c, FMath::DegreesToRadians(yaw), halfFov, visibleRooms);
+
+		for (size_t i = 0; i < rooms.size() && i < visibleRooms.size(); i++)
+		{
+			if (rooms[i] && visibleRooms[i] != shownRooms[i])
+			{
+				rooms[i]->setRoomVisible(visibleRooms[i] != 0);
+				shownRooms[i] = visibleRooms[i];
+			}
+		}
+	}
+
+	//enemies wander, so they are hidden by the room they stand in now rather than the one that spawned them
+	const RoomGraph& graph = currentFloor->getGraph();
+	for (ARoom* room : rooms)
+	{
+		if (!room)
+		{
+			continue;
+		}
+		for (AActor* actor : room->enemies)
+		{
+			if (!IsValid(actor))
+			{
+				continue;
+			}
+			const FVector position = actor->GetActorLocation();
+			const int standing = graph.findRoom(position.X / 100.f, position.Y / 100.f);
+			const bool hidden = standing >= 0 && standing < static_cast<int>(visibleRooms.size()) && !visibleRooms[standing];
+			if (actor->IsHidden() != hidden)
+			{
+				actor->SetActorHiddenInGame(hidden);
+			}
+		}
+	}
+}
+
+void AGenerator::prepareNextFloor(int32 nextSeed)
+{
+	cancelNextFloor();
+
+	const size_t cap = static_cast<size_t>(nextFloorMemoryCapMB) * 1024 * 1024;
+	if (FloorPlan::estimateMemoryUsage(size) > cap)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Next floor of size %d does not fit in %d MB, it will be generated at the gate"),
+		       size, nextFloorMemoryCapMB);
+		return;
+	}
+
+	if (!nextSeed)
+	{
+		nextSeed = RandomGenerator().getRandom();
+	}
+
+	//the task only holds copies and a shared cancel flag, so it can outlive the generator
+	TSharedPtr<std::atomic<bool>> cancel = MakeShared<std::atomic<bool>>(false);
+	std::shared_ptr<const BoundaryMask> mask = makeBoundary(boundary, size, nextSeed);
+	nextFloorCancel = cancel;
+	nextFloorBoundary = boundary;
+	nextFloorTask = Async(EAsyncExecution::ThreadPool,
+	                      [cancel, cap, mask, tSize = size, tRoom_min = room_min, tRoom_max = room_max, tGap = gap,
+		                      nextSeed]
+	                      {
+		                      TSharedPtr<FloorPlan> plan = MakeShared<FloorPlan>(tSize, tRoom_min, tRoom_max, tGap, nextSeed);
+		                      plan->setBoundary(mask);
+		                      unless(plan->generate(nullptr, cancel.Get()))
+		                      {
+			                      return TSharedPtr<FloorPlan>();
+		                      }
+		                      if (plan->getMemoryUsage() > cap)
+		                      {
+			                      UE_LOG(LogTemp, Warning, TEXT("Dropped prepared floor %d, it needs %llu bytes"),
+			                             nextSeed, static_cast<uint64>(plan->getMemoryUsage()));
+			                      return TSharedPtr<FloorPlan>();
+		                      }
+		                      return plan;
+	                      });
+}
+
+void AGenerator::collectNextFloor()
+{
+	if (nextFloorTask.IsValid() && nextFloorTask.IsReady())
+	{
+		nextFloor = nextFloorTask.Get();
+		nextFloorTask.Reset();
+		nextFloorCancel.Reset();
+	}
+}
+
+bool AGenerator::isNextFloorReady()
+{
+	collectNextFloor();
+	return nextFloor.IsValid();
+}
+
+bool AGenerator::commitNextFloor()
+{
+	if (nextFloorTask.IsValid())
+	{
+		//the player beat the worker to the gate, finishing its run is still cheaper than starting over
+		nextFloorTask.Wait();
+	}
+	collectNextFloor();
+
+	unless(HasAuthority())
+	{
+		return false;
+	}
+
+	unless(nextFloor.IsValid())
+	{
+		seed = 0;
+		buildDungeon();
+		return false;
+	}
+
+	TSharedPtr<FloorPlan> plan = MoveTemp(nextFloor);
+	nextFloor.Reset();
+	buildFloor(plan, nextFloorBoundary);
+	return true;
+}
+
+void AGenerator::cancelNextFloor()
+{
+	if (nextFloorCancel.IsValid())
+	{
+		nextFloorCancel->store(true);
+	}
+	nextFloorCancel.Reset();
+	nextFloorTask.Reset();
+	nextFloor.Reset();
+}
+
+void AGenerator::BeginDestroy()
+{
+	UE_LOG(LogTemp, Warning, TEXT("begin destroy called"));
+
+	cancelNextFloor();
+	clearDungeon();
+	Super::BeginDestroy();
+}
+
+void AGenerator::clearDungeon()
+{
+	RELICS_SCOPE(ClearDungeon);
+
+	TArray<AActor*> foundRoomActors;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ARoom::StaticClass(), foundRoomActors);
+
+	for (auto actor : foundRoomActors)
+	{
+		ARoom* room = Cast<ARoom>(actor);
+		if (room)
+		{
+			dirtyNavigationAreas.Add(room->GetComponentsBoundingBox(true));
+			room->clearActors();
+		}
+		actor->Destroy();
+	}
+	RELICS_COUNT(ActorsDestroyed, foundRoomActors.Num());
+	rooms.clear();
+	RELICS_GAUGE(Rooms, 0);
+
+	if (corridorBlocks && corridorBlocks->GetInstanceCount() > 0)
+	{
+		dirtyNavigationAreas.Add(corridorBlocks->Bounds.GetBox());
+		corridorBlocks->ClearInstances();
+	}
+
+	if (enemyProxyMeshes)
+	{
+		enemyProxyMeshes->ClearInstances();
+	}
+
+	for (UDungeonCollisionComponent* collider : wallColliders)
+	{
+		if (IsValid(collider))
+		{
+			dirtyNavigationAreas.Add(collider->Bounds.GetBox());
+			collider->DestroyComponent();
+		}
+	}
+	wallColliders.Reset();
+
+	for (UInstancedStaticMeshComponent* instances : propInstances)
+	{
+		if (IsValid(instances))
+		{
+			dirtyNavigationAreas.Add(instances->Bounds.GetBox());
+			instances->DestroyComponent();
+		}
+	}
+	propInstances.Reset();
+
+	TArray<AActor*> foundEnemyActors;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), enemy, foundEnemyActors);
+
+	//replicated actors belong to the server, clients only let go of their bindings
+	for (auto enemyActor : foundEnemyActors)
+	{
+		if (enemyActor && HasAuthority())
+		{
+			enemyActor->Destroy();
+			RELICS_COUNT(ActorsDestroyed, 1);
+		}
 	}
 }
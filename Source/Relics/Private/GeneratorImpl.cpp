@@ -1,115 +1,453 @@
 #include "GeneratorImpl.h"
 
+#include "GridScans.h"
+
 bool GeneratorImpl::generate()
 {
-	round();
-	return placeStuff();
+	return generate(GenerationBudget()).status == GenerationStatus::Complete;
+}
+
+GenerationReport GeneratorImpl::generate(const GenerationBudget& budget)
+{
+	if (report.status != GenerationStatus::Partial)
+	{
+		return report;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	int attempts = 0;
+	while (report.status == GenerationStatus::Partial)
+	{
+		//limits are only looked at between rooms, so a budget never leaves one half built
+		if (steps.getStep() == GenerationStep::Attempt)
+		{
+			if (cancel && cancel->load(std::memory_order_relaxed))
+			{
+				finish(GenerationStatus::Cancelled);
+				break;
+			}
+			//checked between attempts, so a call overruns its time by at most one scan
+			if (budget.attempts && attempts >= budget.attempts)
+			{
+				break;
+			}
+			if (budget.milliseconds > 0 && std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count() >= budget.milliseconds)
+			{
+				break;
+			}
+			attempts++;
+		}
+		steps.next();
+	}
+	updateReport(start);
+	return report;
 }
 
-const std::vector<RoomImpl>& GeneratorImpl::getRooms() const
+GenerationStep GeneratorImpl::step()
+{
+	if (report.status == GenerationStatus::Partial)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		steps.next();
+		updateReport(start);
+	}
+	return getStep();
+}
+
+GenerationStep GeneratorImpl::getStep() const
+{
+	return report.status == GenerationStatus::Partial ? steps.getStep() : GenerationStep::Done;
+}
+
+void GeneratorImpl::finish(const GenerationStatus status)
+{
+	report.status = status;
+	if (log)
+	{
+		log->end(status == GenerationStatus::Complete);
+	}
+}
+
+void GeneratorImpl::updateReport(const std::chrono::steady_clock::time_point start)
+{
+	report.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	report.rooms = static_cast<int>(rooms.size());
+	report.coverage = freeCells ? static_cast<float>(placedCells) / static_cast<float>(freeCells) : 0.f;
+}
+
+const GenerationReport& GeneratorImpl::getReport() const
+{
+	return report;
+}
+
+const RoomList& GeneratorImpl::getRooms() const
 {
 	return rooms;
 }
 
+int GeneratorImpl::getOpenCells() const
+{
+	return freeCells - placedCells;
+}
+
+int GeneratorImpl::getRoomMin() const
+{
+	return room_min;
+}
+
+int GeneratorImpl::getRoomMax() const
+{
+	return room_max;
+}
+
+std::pmr::memory_resource* GeneratorImpl::getMemory() const
+{
+	return memory;
+}
+
 RandomGenerator& GeneratorImpl::getRandomGenerator()
 {
 	return rg;
 }
 
-void GeneratorImpl::round()
+RoomIdLayer& GeneratorImpl::getRoomIds()
 {
-	const auto max = static_cast<float>(size);
-	const auto center = max / 2.f;
-	for (float i = 0; i < max; i++)
+	return roomIds;
+}
+
+int GeneratorImpl::routeCorridors(const RoomGraph& graph)
+{
+	//one router per thread keeps its buffers from floor to floor
+	static thread_local CorridorRouter router;
+	router.reset(grid, graph.getRoomIds());
+	const int failed = router.routeAll(graph, corridors);
+
+	//a partial layout still has rooms to place, and corridor cells would take space from them
+	if (report.status == GenerationStatus::Partial)
+	{
+		return failed;
+	}
+	for (const auto& corridor : corridors)
 	{
-		for (float j = 0; j < max; j++)
+		for (const auto& [r, c] : corridor.cells)
 		{
-			auto d = static_cast<float>(sqrt(
-				pow(center - (i > center ? i : i + 1), 2) + center
-				+ pow(center - (j > center ? j : j + 1), 2) + center));
-			if (d > center)
+			if (grid.get(r, c) == '-')
 			{
-				grid.set(i, j, 'X');
+				grid.set(r, c, '.');
 			}
 		}
 	}
+	return failed;
+}
+
+CorridorList& GeneratorImpl::getCorridors()
+{
+	return corridors;
+}
+
+void GeneratorImpl::setLog(GenerationLog* generationLog)
+{
+	log = generationLog;
+}
+
+void GeneratorImpl::setCancel(const std::atomic<bool>* cancelFlag)
+{
+	cancel = cancelFlag;
 }
 
-bool GeneratorImpl::placeStuff()
+void GeneratorImpl::setPlacementCheck(const PlacementCheck* placementCheck)
 {
-	int id = 0;
-	int retries = 0;
-	while (openSpace())
+	check = placementCheck;
+}
+
+void GeneratorImpl::setBoundary(const BoundaryMask* mask)
+{
+	boundary = mask;
+}
+
+void GeneratorImpl::applyBoundary()
+{
+	const CircleMask circle;
+	const BoundaryMask& mask = boundary ? *boundary : circle;
+
+	//everything between the open spans of a row is masked off a run at a time
+	const auto maskRows = [this, &mask](const int first, const int last, std::pmr::vector<MaskSpan>& spans)
 	{
-		unless(placeThing(id))
+		int open = 0;
+		for (int r = first; r < last; r++)
 		{
-			if (++retries > 5)
+			spans.clear();
+			mask.getSpans(r, size, spans);
+			int c = 0;
+			for (const auto& [from, to] : spans)
 			{
-				return false;
+				grid.fillRow(r, c, from, 'X');
+				open += to - from;
+				c = to;
 			}
+			grid.fillRow(r, c, size, 'X');
 		}
-		else
-		{
-			retries = 0;
-			if (++id + '0' == 'X')
-			{
-				id++;
-			};
+		return open;
+	};
 
-			std::cout << *this << std::endl;
+	unless(useParallelScan(size))
+	{
+		std::pmr::vector<MaskSpan> spans(memory);
+		freeCells += maskRows(0, size, spans);
+		return;
+	}
+
+	//rows only ever write their own cells and words, so bands of them are masked side by side
+	const int bands = static_cast<int>(pool.getThreadCount()) * BANDS_PER_THREAD;
+	const int rowsPerBand = (size + bands - 1) / bands;
+	std::atomic<int> open(0);
+	pool.parallelFor(bands, [&](const int band)
+	{
+		std::pmr::vector<MaskSpan> spans;
+		open += maskRows(band * rowsPerBand, std::min(size, (band + 1) * rowsPerBand), spans);
+	});
+	freeCells += open.load();
+}
+
+template <typename Body>
+decltype(auto) GeneratorImpl::withScan(const Body& body) const
+{
+	//the sizes and gaps the game ships with, anything else is scanned through TwoDArray
+	if (gap == 3)
+	{
+		switch (size)
+		{
+		case 32: return body(PresetScan<32, 3>(grid, room_min));
+		case 64: return body(PresetScan<64, 3>(grid, room_min));
+		case 128: return body(PresetScan<128, 3>(grid, room_min));
+		case 256: return body(PresetScan<256, 3>(grid, room_min));
+		default: break;
 		}
 	}
-	return true;
+	else if (gap == 2)
+	{
+		switch (size)
+		{
+		case 32: return body(PresetScan<32, 2>(grid, room_min));
+		case 64: return body(PresetScan<64, 2>(grid, room_min));
+		case 128: return body(PresetScan<128, 2>(grid, room_min));
+		case 256: return body(PresetScan<256, 2>(grid, room_min));
+		default: break;
+		}
+	}
+	return body(DynamicScan{grid, gap, room_min});
 }
 
-bool GeneratorImpl::openSpace() const
+template <typename Scan>
+bool GeneratorImpl::openSpace(const Scan& scan) const
 {
-	for (auto i = 0; i < size; i++)
+	unless(useParallelScan(size))
 	{
-		for (auto j = 0; j < size; j++)
+		for (auto i = 0; i < size; i++)
 		{
-			int s = 0;
-			while (grid.isEmpty(i, j, s, gap))
+			for (auto j = 0; j < size; j++)
 			{
-				s++;
+				if (log)
+				{
+					log->probe(GenerationEvent::ProbeSpace, i, j);
+				}
+				if (scan.hasSpace(i, j))
+				{
+					return true;
+				}
 			}
-			if (s > room_min)
+		}
+		return false;
+	}
+
+	//any hit answers the question, so every band stops as soon as one is found
+	std::atomic<bool> found(false);
+	const int bands = std::min(size, static_cast<int>(pool.getThreadCount()) * BANDS_PER_THREAD);
+	pool.parallelFor(bands, [&](const int band)
+	{
+		for (auto i = band * size / bands; i < (band + 1) * size / bands && !found.load(std::memory_order_relaxed); i++)
+		{
+			for (auto j = 0; j < size; j++)
 			{
-				return true;
+				if (scan.hasSpace(i, j))
+				{
+					found.store(true, std::memory_order_relaxed);
+					return;
+				}
 			}
 		}
-	}
-	return false;
+	});
+	return found.load();
 }
 
-bool GeneratorImpl::placeThing(const char id)
+template <typename Scan>
+int GeneratorImpl::findFit(const Scan& scan, const int width, const int height) const
 {
-	const int width = rg.getRandom(room_min, room_max);
-	const int height = rg.getRandom(room_min, room_max);
+	const int rows = size - height;
+	const int cols = size - width;
+	if (rows <= 0 || cols <= 0)
+	{
+		return -1;
+	}
 
-	if (width >= 3 && height >= 3)
+	unless(useParallelScan(rows))
 	{
-		for (auto i = 0; i < size - height; i++)
+		for (auto i = 0; i < rows; i++)
 		{
-			for (auto j = 0; j < size - width; j++)
+			for (auto j = 0; j < cols;)
 			{
-				if (grid.isEmpty(i, j, width, height, gap))
+				if (log)
 				{
-					rooms.emplace_back(id, i, j, width, height, rg);
-					rooms[rooms.size() - 1].draw(grid);
-					return true;
+					log->probe(GenerationEvent::ProbeFit, i, j);
+				}
+				const int next = scan.nextFit(i, j, width, height);
+				if (next == j)
+				{
+					return i * cols + j;
+				}
+				j = next;
+			}
+		}
+		return -1;
+	}
+
+	//the first fit in scan order is the smallest hit index over all bands
+	//a band gives up once it is past the best hit so far, so layouts match the serial scan exactly
+	std::atomic<int> best(std::numeric_limits<int>::max());
+	const int bands = std::min(rows, static_cast<int>(pool.getThreadCount()) * BANDS_PER_THREAD);
+	pool.parallelFor(bands, [&](const int band)
+	{
+		for (auto i = band * rows / bands; i < (band + 1) * rows / bands; i++)
+		{
+			if (i * cols >= best.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			for (auto j = 0; j < cols;)
+			{
+				const int next = scan.nextFit(i, j, width, height);
+				if (next == j)
+				{
+					int hit = i * cols + j;
+					int current = best.load();
+					while (hit < current && !best.compare_exchange_weak(current, hit))
+					{
+					}
+					return;
 				}
+				j = next;
 			}
 		}
+	});
+	const int hit = best.load();
+	return hit == std::numeric_limits<int>::max() ? -1 : hit;
+}
+
+GenerationSteps GeneratorImpl::run()
+{
+	if (log)
+	{
+		log->begin(size, room_min, room_max, gap, rg.getSeed());
+	}
+	applyBoundary();
+	if (log)
+	{
+		log->mask();
+	}
+
+	const auto openSpaceScan = [this](const auto& scan)
+	{
+		return openSpace(scan);
+	};
+	while (withScan(openSpaceScan))
+	{
+		co_yield GenerationStep::Attempt;
+		report.attempts++;
+
+		const int width = rg.getRandom(room_min, room_max);
+		const int height = rg.getRandom(room_min, room_max);
+		const auto findFitScan = [this, width, height](const auto& scan)
+		{
+			return findFit(scan, width, height);
+		};
+		const int hit = width >= 3 && height >= 3 ? withScan(findFitScan) : -1;
+		if (hit < 0)
+		{
+			if (log)
+			{
+				log->retry(retries + 1);
+			}
+			if (++retries > 5)
+			{
+				finish(GenerationStatus::Failed);
+				co_return;
+			}
+			continue;
+		}
+
+		//the room is built in the order its constructor would, so stepping draws the same numbers
+		const char id = static_cast<char>(nextId);
+		const int i = hit / (size - width);
+		const int j = hit % (size - width);
+		if (log)
+		{
+			log->place(id, i, j, width, height);
+		}
+		RoomImpl& room = rooms.emplace_back(id, i, j, width, height);
+		co_yield GenerationStep::Placed;
+
+		room.reshape(rg);
+		if (log)
+		{
+			log->reshape(id, static_cast<unsigned char>(room.getShape()));
+		}
+		co_yield GenerationStep::Reshaped;
+
+		room.addDoors(rg);
+		if (log)
+		{
+			for (const auto& door : room.getDoors())
+			{
+				log->door(id, door.first + i, door.second + j);
+			}
+		}
+		room.draw(grid);
+		placedCells += width * height;
+		roomIds.stamp(room, static_cast<int>(rooms.size()) - 1);
+		co_yield GenerationStep::Doors;
+
+		retries = 0;
+		if (++nextId + '0' == 'X')
+		{
+			nextId++;
+		}
+		if (check && !(*check)(*this))
+		{
+			finish(GenerationStatus::Rejected);
+			co_return;
+		}
 	}
-	return false;
+	finish(GenerationStatus::Complete);
+}
+
+bool GeneratorImpl::useParallelScan(const int rows) const
+{
+	//probe events have to stay in scan order, and tiny grids are not worth waking the pool for
+	//queuing tasks allocates, so runs on an arena are expected to be spread over threads a seed at a time instead
+	return !log && memory == std::pmr::get_default_resource() && pool.getThreadCount() > 1
+		&& rows * size >= PARALLEL_SCAN_CELLS;
 }
 
 GeneratorImpl::GeneratorImpl(const int size, const int room_min, const int room_max,
-                             const int gap, const int seed) :
-	grid(TwoDArray(size, size)), size(size), room_min(room_min),
-	room_max(room_max), gap(gap), rg(RandomGenerator(seed))
+                             const int gap, const int seed, std::pmr::memory_resource* memory) :
+	grid(size, size, '-', memory), size(size), room_min(room_min),
+	room_max(room_max), gap(gap), rg(RandomGenerator(seed)), rooms(memory), roomIds(size, memory), corridors(memory),
+	log(nullptr), cancel(nullptr), check(nullptr), pool(TaskPool::shared()), memory(memory), boundary(nullptr),
+	nextId(0), retries(0), freeCells(0), placedCells(0)
 {
+	//nothing runs until the first resume, so the boundary and the log can still be set
+	steps = run();
 }
 
 GeneratorImpl::~GeneratorImpl() = default;
@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "TwoDArray.h"
+
+//the two questions the placement scans ask of every cell, through TwoDArray for any size and gap
+struct DynamicScan
+{
+    const TwoDArray& grid;
+    int gap;
+    int roomMin;
+
+    //whether a square bigger than the smallest room grows from (i, j)
+    [[nodiscard]] bool hasSpace(const int i, const int j) const
+    {
+        int s = 0;
+        while (grid.isEmpty(i, j, s, gap))
+        {
+            s++;
+        }
+        return s > roomMin;
+    }
+
+    //j when the footprint fits at (i, j), otherwise the next column worth trying
+    [[nodiscard]] int nextFit(const int i, const int j, const int width, const int height) const
+    {
+        return grid.isEmpty(i, j, width, height, gap) ? j : j + 1;
+    }
+};
+
+//the same answers for one size and gap known at compile time, read straight off the bits
+//the band around the bits stands in for the grid's edge, so no access is clipped or checked, and every mask is
+//taken from a table instead of shifted out per call
+template <int Size, int Gap>
+class PresetScan
+{
+    static_assert(Gap >= 0 && Gap <= BitGrid::GUARD, "the band has to reach as far as the gap");
+
+    static constexpr int WORDS = BitGrid::wordsFor(Size);
+    //HIGH[n] keeps bits n..63 and LOW[n] bits 0..n
+    static constexpr std::array<uint64_t, 64> HIGH = []
+    {
+        std::array<uint64_t, 64> masks{};
+        for (int n = 0; n < 64; n++)
+        {
+            masks[n] = ~uint64_t(0) << n;
+        }
+        return masks;
+    }();
+    static constexpr std::array<uint64_t, 64> LOW = []
+    {
+        std::array<uint64_t, 64> masks{};
+        for (int n = 0; n < 64; n++)
+        {
+            masks[n] = ~uint64_t(0) >> (63 - n);
+        }
+        return masks;
+    }();
+
+    const uint64_t* occupied;
+    const uint64_t* masked;
+    int roomMin;
+
+    //columns are shifted by a word, so the band left of column 0 is word 0 and nothing is negative
+    [[nodiscard]] static bool bit(const uint64_t* bits, const int r, const int c)
+    {
+        const int shifted = c + 64;
+        return bits[r * WORDS + (shifted >> 6) - 1] >> (shifted & 63) & 1;
+    }
+
+    //the rightmost set column in rows r0..r1 and columns c0..c1, both inclusive, or -1 when nothing is set
+    //the band counts as part of the grid, and words left of the best column so far are not looked at
+    [[nodiscard]] static int rightmost(const uint64_t* bits, const int r0, const int c0, const int r1, const int c1)
+    {
+        const int first = (c0 + 64) >> 6;
+        const int last = (c1 + 64) >> 6;
+        const uint64_t head = HIGH[(c0 + 64) & 63];
+        const uint64_t tail = LOW[(c1 + 64) & 63];
+        int found = -1;
+        for (int r = r0; r <= r1 && found < c1; r++)
+        {
+            const uint64_t* row = bits + r * WORDS - 1;
+            for (int w = last; w >= first && w * 64 - 1 > found; w--)
+            {
+                const uint64_t word = row[w] & (w == first ? head : ~uint64_t(0)) & (w == last ? tail : ~uint64_t(0));
+                if (word)
+                {
+                    found = std::max(found, w * 64 - 1 - std::countl_zero(word));
+                    break;
+                }
+            }
+        }
+        return found;
+    }
+
+    //TwoDArray::isEmpty for the ring s cells out, the band reads as the 'X' an off-grid get would
+    [[nodiscard]] bool isRingEmpty(const int r, const int c, const int s) const
+    {
+        if (s == 0)
+        {
+            return !bit(occupied, r, c) && !bit(masked, r, c);
+        }
+        if (r + s >= Size || c + s >= Size)
+        {
+            return false;
+        }
+        for (int i = -Gap; i < s + Gap; i++)
+        {
+            const bool aMasked = bit(masked, r + s, c + i);
+            const bool bMasked = bit(masked, r + i, c + s);
+            if (!aMasked && !bMasked && !bit(occupied, r + s, c + i) && !bit(occupied, r + i, c + s))
+            {
+                continue;
+            }
+            if ((aMasked || bMasked) && (i < 0 || i > s))
+            {
+                continue;
+            }
+            return false;
+        }
+        return true;
+    }
+
+public:
+    PresetScan(const TwoDArray& grid, const int roomMin)
+        : occupied(grid.getOccupied().getOrigin()), masked(grid.getMasked().getOrigin()), roomMin(roomMin)
+    {
+    }
+
+    //the answer only depends on the rings up to roomMin, so the scan stops there instead of at the first wall
+    [[nodiscard]] bool hasSpace(const int i, const int j) const
+    {
+        for (int s = 0; s <= roomMin; s++)
+        {
+            unless(isRingEmpty(i, j, s))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //the scans only ask about footprints inside the grid, which is the case isEmpty answers from the bits
+    //a miss skips every column the same blocking cells rule out, so the first fit found is still the first there is
+    [[nodiscard]] int nextFit(const int i, const int j, const int width, const int height) const
+    {
+        constexpr int INNER = Gap > 0 ? 0 : 1;
+        const int innerRow = i + height - INNER;
+        const int innerCol = j + width - INNER;
+        //a mask cell rules out every footprint still covering it, a drawn one every footprint whose gap reaches it
+        const int mask = innerRow >= i && innerCol >= j ? rightmost(masked, i, j, innerRow, innerCol) : -1;
+        const int drawn = rightmost(occupied, i - Gap, j - Gap, i + height + Gap - 1, j + width + Gap - 1);
+        int next = j;
+        if (mask >= 0)
+        {
+            next = mask + 1;
+        }
+        if (drawn >= 0)
+        {
+            next = std::max(next, drawn + Gap + 1);
+        }
+        return next;
+    }
+};
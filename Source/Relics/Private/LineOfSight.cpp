@@ -0,0 +1,142 @@
+#include "LineOfSight.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "TaskPool.h"
+
+LineOfSight::LineOfSight(const WallGrid& walls)
+	: walls(walls), pendingFirst(0), resultsFirst(0)
+{
+}
+
+bool LineOfSight::isRowClear(const int r, const int from, const int to) const
+{
+	if (from > to)
+	{
+		return true;
+	}
+	if (r < 0 || r >= walls.getSize() || from < 0 || to >= walls.getSize())
+	{
+		return false;
+	}
+	const uint64_t* row = walls.getRow(r);
+	for (int w = from / 64; w <= to / 64; w++)
+	{
+		const int low = std::max(from, w * 64) % 64;
+		const int high = std::min(to, w * 64 + 63) % 64;
+		const uint64_t mask = (~uint64_t(0) << low) & (~uint64_t(0) >> (63 - high));
+		if (row[w] & mask)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LineOfSight::isClear(const float fromR, const float fromC, const float toR, const float toC) const
+{
+	int r = static_cast<int>(std::floor(fromR));
+	int c = static_cast<int>(std::floor(fromC));
+	const int endR = static_cast<int>(std::floor(toR));
+	const int endC = static_cast<int>(std::floor(toC));
+	if (r == endR)
+	{
+		return isRowClear(r, std::min(c, endC) + 1, std::max(c, endC) - 1);
+	}
+
+	//amanatides and woo, t runs from 0 at the start to 1 at the end and each axis steps at its next cell border
+	constexpr float NEVER = std::numeric_limits<float>::infinity();
+	const float dr = toR - fromR;
+	const float dc = toC - fromC;
+	const int stepR = dr > 0 ? 1 : -1;
+	const int stepC = dc > 0 ? 1 : dc < 0 ? -1 : 0;
+	const float deltaR = 1.f / std::abs(dr);
+	const float deltaC = stepC ? 1.f / std::abs(dc) : NEVER;
+	float nextR = (dr > 0 ? static_cast<float>(r + 1) - fromR : fromR - static_cast<float>(r)) * deltaR;
+	float nextC = stepC ? (dc > 0 ? static_cast<float>(c + 1) - fromC : fromC - static_cast<float>(c)) * deltaC : NEVER;
+
+	//rounding can carry the walk past the end, it never takes more steps than the cells between them
+	for (int steps = std::abs(endR - r) + std::abs(endC - c); steps > 0; steps--)
+	{
+		if (nextR < nextC)
+		{
+			r += stepR;
+			nextR += deltaR;
+		}
+		else if (nextC < nextR)
+		{
+			c += stepC;
+			nextC += deltaC;
+		}
+		else
+		{
+			if (walls.isWall(r + stepR, c) && walls.isWall(r, c + stepC))
+			{
+				return false;
+			}
+			r += stepR;
+			c += stepC;
+			nextR += deltaR;
+			nextC += deltaC;
+			steps--;
+		}
+		if (r == endR && c == endC)
+		{
+			return true;
+		}
+		if (walls.isWall(r, c))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int LineOfSight::submit(const SightQuery& query)
+{
+	pending.push_back(query);
+	return pendingFirst + static_cast<int>(pending.size()) - 1;
+}
+
+void LineOfSight::run()
+{
+	//the gathered batch becomes the running one, its storage is reused by the next
+	std::swap(pending, running);
+	pending.clear();
+	resultsFirst = pendingFirst;
+	pendingFirst += static_cast<int>(running.size());
+	results.assign(running.size(), 0);
+
+	const int count = static_cast<int>(running.size());
+	TaskPool::shared().parallelFor((count + CHUNK - 1) / CHUNK, [this, count](const int chunk)
+	{
+		for (int i = chunk * CHUNK; i < std::min(count, (chunk + 1) * CHUNK); i++)
+		{
+			const SightQuery& query = running[i];
+			results[i] = isClear(query.fromR, query.fromC, query.toR, query.toC);
+		}
+	});
+}
+
+bool LineOfSight::getResult(const int ticket, bool& clear) const
+{
+	if (ticket < resultsFirst || ticket >= resultsFirst + static_cast<int>(results.size()))
+	{
+		return false;
+	}
+	clear = results[ticket - resultsFirst] != 0;
+	return true;
+}
+
+const std::vector<unsigned char>& LineOfSight::getResults() const
+{
+	return results;
+}
+
+int LineOfSight::getPendingCount() const
+{
+	return static_cast<int>(pending.size());
+}
@@ -0,0 +1,179 @@
+#include "MinimapRaster.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+	//muted tints so neighbouring rooms can be told apart without drowning out the doors
+	constexpr uint32_t ROOM_TINTS[8] = {
+		0xFF3A4A5A, 0xFF4A3A5A, 0xFF3A5A4A, 0xFF5A4A3A, 0xFF4A5A3A, 0xFF5A3A4A, 0xFF404858, 0xFF584840
+	};
+}
+
+MinimapRaster::MinimapRaster(const FloorPlan& plan, const int maxDimension)
+	: size(plan.getSize()), scale(std::max(1, maxDimension / std::max(1, plan.getSize()))),
+	  dimension(size * scale), drawing(static_cast<size_t>(dimension) * dimension, 0),
+	  words((size + 63) / 64), tiles((dimension + TILE - 1) / TILE)
+{
+	explored.assign(static_cast<size_t>(size) * words, 0);
+	dirtyTiles.assign(static_cast<size_t>(tiles) * tiles, 1);
+
+	for (const auto& corridor : plan.getCorridors())
+	{
+		for (const auto& [r, c] : corridor.cells)
+		{
+			fillCell(r, c, CORRIDOR);
+		}
+	}
+
+	const auto& rooms = plan.getRooms();
+	for (size_t i = 0; i < rooms.size(); i++)
+	{
+		const RoomImpl& room = rooms[i].room;
+		const int row = static_cast<int>(room.getRow());
+		const int col = static_cast<int>(room.getCol());
+		const int height = static_cast<int>(room.getHeight());
+		const int width = static_cast<int>(room.getWidth());
+		const uint32_t tint = ROOM_TINTS[i % 8];
+		unless(RoomStamp::fits(height, width))
+		{
+			//too big for a stamp, drawn as its bounding box
+			for (int r = 0; r < height; r++)
+			{
+				for (int c = 0; c < width; c++)
+				{
+					const bool edge = r == 0 || c == 0 || r == height - 1 || c == width - 1;
+					fillCell(row + r, col + c, edge ? WALL : tint);
+				}
+			}
+			continue;
+		}
+
+		const RoomStamp stamp = room.getStamp();
+		for (int r = 0; r < height; r++)
+		{
+			const uint64_t cells[3] = {stamp.floor[r], stamp.walls[r] & ~stamp.doors[r], stamp.doors[r]};
+			const uint32_t colours[3] = {tint, WALL, DOOR};
+			for (int k = 0; k < 3; k++)
+			{
+				for (uint64_t rest = cells[k]; rest; rest &= rest - 1)
+				{
+					fillCell(row + r, col + std::countr_zero(rest), colours[k]);
+				}
+			}
+		}
+	}
+}
+
+void MinimapRaster::fillCell(const int r, const int c, const uint32_t colour)
+{
+	if (r < 0 || r >= size || c < 0 || c >= size)
+	{
+		return;
+	}
+	for (int y = r * scale; y < (r + 1) * scale; y++)
+	{
+		std::fill_n(drawing.data() + static_cast<size_t>(y) * dimension + c * scale, scale, colour);
+	}
+}
+
+void MinimapRaster::markDirty(const int r0, const int c0, const int r1, const int c1)
+{
+	for (int ty = r0 * scale / TILE; ty <= ((r1 + 1) * scale - 1) / TILE; ty++)
+	{
+		for (int tx = c0 * scale / TILE; tx <= ((c1 + 1) * scale - 1) / TILE; tx++)
+		{
+			dirtyTiles[ty * tiles + tx] = 1;
+		}
+	}
+}
+
+bool MinimapRaster::isExplored(const int r, const int c) const
+{
+	return explored[static_cast<size_t>(r) * words + c / 64] >> (c % 64) & 1;
+}
+
+int MinimapRaster::getDimension() const
+{
+	return dimension;
+}
+
+int MinimapRaster::getScale() const
+{
+	return scale;
+}
+
+int MinimapRaster::reveal(int r0, int c0, int r1, int c1)
+{
+	r0 = std::max(r0, 0);
+	c0 = std::max(c0, 0);
+	r1 = std::min(r1, size - 1);
+	c1 = std::min(c1, size - 1);
+	if (r0 > r1 || c0 > c1)
+	{
+		return 0;
+	}
+
+	int revealed = 0;
+	for (int r = r0; r <= r1; r++)
+	{
+		//a word of the row at a time, the part of it inside c0..c1
+		uint64_t* row = explored.data() + static_cast<size_t>(r) * words;
+		for (int w = c0 / 64; w <= c1 / 64; w++)
+		{
+			const int from = std::max(c0, w * 64) % 64;
+			const int to = std::min(c1, w * 64 + 63) % 64;
+			const uint64_t mask = (~uint64_t(0) << from) & (~uint64_t(0) >> (63 - to));
+			revealed += std::popcount(mask & ~row[w]);
+			row[w] |= mask;
+		}
+	}
+	if (revealed)
+	{
+		markDirty(r0, c0, r1, c1);
+	}
+	return revealed;
+}
+
+int MinimapRaster::reveal(const int r, const int c)
+{
+	return reveal(r, c, r, c);
+}
+
+void MinimapRaster::takeDirty(std::vector<MinimapRegion>& regions)
+{
+	for (int ty = 0; ty < tiles; ty++)
+	{
+		for (int tx = 0; tx < tiles;)
+		{
+			unless(dirtyTiles[ty * tiles + tx])
+			{
+				tx++;
+				continue;
+			}
+			const int first = tx;
+			while (tx < tiles && dirtyTiles[ty * tiles + tx])
+			{
+				dirtyTiles[ty * tiles + tx++] = 0;
+			}
+			const int x = first * TILE;
+			const int y = ty * TILE;
+			regions.push_back({x, y, std::min(tx * TILE, dimension) - x, std::min(y + TILE, dimension) - y});
+		}
+	}
+}
+
+void MinimapRaster::copyRegion(const MinimapRegion& region, uint32_t* out, const int pitch) const
+{
+	for (int y = 0; y < region.height; y++)
+	{
+		const int r = (region.y + y) / scale;
+		const uint32_t* source = drawing.data() + static_cast<size_t>(region.y + y) * dimension + region.x;
+		uint32_t* target = out + static_cast<size_t>(y) * pitch;
+		for (int x = 0; x < region.width; x++)
+		{
+			target[x] = isExplored(r, (region.x + x) / scale) ? source[x] : 0;
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include "PortalVisibility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+	float wrap(float angle)
+	{
+		while (angle > std::numbers::pi_v<float>)
+		{
+			angle -= 2 * std::numbers::pi_v<float>;
+		}
+		while (angle <= -std::numbers::pi_v<float>)
+		{
+			angle += 2 * std::numbers::pi_v<float>;
+		}
+		return angle;
+	}
+}
+
+PortalVisibility::Wedge PortalVisibility::extent(const float r, const float c, const float yaw, const float r0,
+                                                 const float c0, const float r1, const float c1)
+{
+	if (r >= r0 && r <= r1 && c >= c0 && c <= c1)
+	{
+		return {-2 * std::numbers::pi_v<float>, 2 * std::numbers::pi_v<float>};
+	}
+
+	//a box the camera is not inside spans less than pi, so its corners unwrap around its centre without ambiguity
+	const float centre = wrap(std::atan2((c0 + c1) / 2 - c, (r0 + r1) / 2 - r) - yaw);
+	Wedge wedge = {centre, centre};
+	const float corners[4][2] = {{r0, c0}, {r0, c1}, {r1, c0}, {r1, c1}};
+	for (const auto& corner : corners)
+	{
+		const float angle = centre + wrap(std::atan2(corner[1] - c, corner[0] - r) - yaw - centre);
+		wedge.lo = std::min(wedge.lo, angle);
+		wedge.hi = std::max(wedge.hi, angle);
+	}
+	return wedge;
+}
+
+bool PortalVisibility::clip(const Wedge& a, const Wedge& b, Wedge& out)
+{
+	//b may sit a full turn away from a when it straddles the direction behind the camera
+	for (const float shift : {0.f, 2 * std::numbers::pi_v<float>, -2 * std::numbers::pi_v<float>})
+	{
+		const float lo = std::max(a.lo, b.lo + shift);
+		const float hi = std::min(a.hi, b.hi + shift);
+		if (lo <= hi)
+		{
+			out = {lo, hi};
+			return true;
+		}
+	}
+	return false;
+}
+
+PortalVisibility::PortalVisibility(const RoomGraph& graph, const float maxDistance)
+	: graph(graph), maxDistance(maxDistance)
+{
+}
+
+int PortalVisibility::computeVisible(const float r, const float c, const float yaw, const float halfFov,
+                                     std::vector<unsigned char>& visible)
+{
+	visible.assign(graph.getRoomCount(), 0);
+	wedges.clear();
+
+	const Wedge frustum = {-halfFov, halfFov};
+	const int camera = graph.findRoom(r, c);
+	if (camera >= 0)
+	{
+		visible[camera] = 1;
+
+		//the camera room's walls hide everything except what lines up with one of its doors
+		for (const DoorCell* door = graph.doorsBegin(camera); door != graph.doorsEnd(camera); ++door)
+		{
+			Wedge through;
+			if (clip(frustum, extent(r, c, yaw, door->r, door->c, door->r + 1, door->c + 1), through))
+			{
+				wedges.push_back(through);
+			}
+		}
+	}
+	else
+	{
+		wedges.push_back(frustum);
+	}
+
+	if (wedges.empty())
+	{
+		return camera;
+	}
+
+	//the gap band between rooms is open, so anything in a wedge is kept; other rooms' walls are not used as
+	//occluders, which keeps the set conservative
+	nearby.clear();
+	graph.roomsNear(r, c, maxDistance, nearby);
+	for (const int room : nearby)
+	{
+		if (visible[room])
+		{
+			continue;
+		}
+		const RoomBounds& b = graph.getBounds(room);
+		//one extra cell for the overheads that hang outside the footprint
+		const Wedge box = extent(r, c, yaw, b.row - 1.f, b.col - 1.f, b.row + b.height + 1.f, b.col + b.width + 1.f);
+		for (const Wedge& wedge : wedges)
+		{
+			Wedge seen;
+			if (clip(wedge, box, seen))
+			{
+				visible[room] = 1;
+				break;
+			}
+		}
+	}
+	return camera;
+}
@@ -0,0 +1,46 @@
+#include "RelicsStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(RelicsChannel)
+
+DEFINE_STAT(STAT_RelicsBuildDungeon);
+DEFINE_STAT(STAT_RelicsGenerate);
+DEFINE_STAT(STAT_RelicsBuildFloor);
+DEFINE_STAT(STAT_RelicsClearDungeon);
+DEFINE_STAT(STAT_RelicsRoomInit);
+DEFINE_STAT(STAT_RelicsBuildWalls);
+DEFINE_STAT(STAT_RelicsSpawnActor);
+DEFINE_STAT(STAT_RelicsBuildCorridors);
+DEFINE_STAT(STAT_RelicsBuildColliders);
+DEFINE_STAT(STAT_RelicsBuildProps);
+DEFINE_STAT(STAT_RelicsRebuildNavigation);
+DEFINE_STAT(STAT_RelicsPortalCulling);
+DEFINE_STAT(STAT_RelicsEnemyActivity);
+DEFINE_STAT(STAT_RelicsMinimap);
+DEFINE_STAT(STAT_RelicsFieldOfView);
+DEFINE_STAT(STAT_RelicsLineOfSight);
+DEFINE_STAT(STAT_RelicsRoomPaths);
+
+DEFINE_STAT(STAT_RelicsRoomsSpawned);
+DEFINE_STAT(STAT_RelicsInstancesAdded);
+DEFINE_STAT(STAT_RelicsActorsSpawned);
+DEFINE_STAT(STAT_RelicsActorsDestroyed);
+DEFINE_STAT(STAT_RelicsMinimapRegions);
+DEFINE_STAT(STAT_RelicsFieldOfViewSpans);
+DEFINE_STAT(STAT_RelicsLineOfSightQueries);
+DEFINE_STAT(STAT_RelicsRoomPathQueries);
+
+DEFINE_STAT(STAT_RelicsRooms);
+DEFINE_STAT(STAT_RelicsDormantEnemies);
+DEFINE_STAT(STAT_RelicsEnemyProxies);
+
+TRACE_DECLARE_INT_COUNTER(RelicsRoomsSpawned, TEXT("Relics/Rooms spawned"));
+TRACE_DECLARE_INT_COUNTER(RelicsInstancesAdded, TEXT("Relics/Instances added"));
+TRACE_DECLARE_INT_COUNTER(RelicsActorsSpawned, TEXT("Relics/Actors spawned"));
+TRACE_DECLARE_INT_COUNTER(RelicsActorsDestroyed, TEXT("Relics/Actors destroyed"));
+TRACE_DECLARE_INT_COUNTER(RelicsMinimapRegions, TEXT("Relics/Minimap regions uploaded"));
+TRACE_DECLARE_INT_COUNTER(RelicsFieldOfViewSpans, TEXT("Relics/Field of view spans changed"));
+TRACE_DECLARE_INT_COUNTER(RelicsLineOfSightQueries, TEXT("Relics/Line of sight queries"));
+TRACE_DECLARE_INT_COUNTER(RelicsRoomPathQueries, TEXT("Relics/Room path queries"));
+TRACE_DECLARE_INT_COUNTER(RelicsRooms, TEXT("Relics/Rooms"));
+TRACE_DECLARE_INT_COUNTER(RelicsDormantEnemies, TEXT("Relics/Dormant enemies"));
+TRACE_DECLARE_INT_COUNTER(RelicsEnemyProxies, TEXT("Relics/Enemy proxies"));
@@ -1,211 +1,91 @@
 #include "Room.h"
 #include "Components/InstancedStaticMeshComponent.h"
+#include "DungeonSlotActor.h"
+#include "RelicsStats.h"
 #include "Relics/Utils/Utils.h"
 
-#include <algorithm>
-#include <unordered_set>
-
 #include "Kismet/GameplayStatics.h"
 
-void ARoom::buildWalls()
+FTransform ARoom::getSegmentTransform(const WallSegment& segment)
 {
-	blocked.clear();
-	buildWall(room.getWalls());
-	buildWall(room.getInteriorWalls());
-}
-
-void ARoom::buildWall(std::vector<std::pair<int, int>>& walls)
-{
-	bool isVert = true;
-	std::pair<int, int>* p1 = nullptr;
+	FMatrix transformMatrix = FMatrix(
+		FPlane(segment.rScale * 1.0f, 0.0f, 0.0f, 0.0f),
+		FPlane(0.0f, segment.cScale * 1.0f, 0.0f, 0.0f),
+		FPlane(0.0f, 0.0f, segment.zScale * 1.0f, 0.0f),
+		FPlane(segment.r * 100.0f, segment.c * 100.0f, segment.alt * 100.0f, 1.0f)
+	);
 
-	for (auto& p2 : walls)
-	{
-		if (p1)
-		{
-			isVert ? buildVerticalWall(*p1, p2) : buildHorizontalWall(*p1, p2);
-			isVert = !isVert;
-		}
-		p1 = &p2;
-	}
-	unless(p1 == nullptr)
-	{
-		isVert ? buildVerticalWall(*p1, walls[0]) : buildHorizontalWall(*p1, walls[0]);
-	}
+	return FTransform(transformMatrix);
 }
 
-void ARoom::buildVerticalWall(std::pair<int, int>& p1, std::pair<int, int>& p2)
+UClass* ARoom::getSpawnClass(const SpawnKind kind) const
 {
-	int row = std::min(p1.first, p2.first);
-	int rScale = 0;
-	int rStart = row;
-
-	//loops over the row
-	//scale & loop begins at 1 and row because corners are never doors
-	for (int r = row; r < std::max(p1.first, p2.first) + 1; r++)
+	switch (kind)
 	{
-		//if there is no door then increase the length of the wall segment
-		unless(room.getDoors().contains({r, p1.second}))
-		{
-			rScale++;
-			blocked.insert(std::make_pair(r, p1.second));
-		}
-		//if there is a door then build a segment from the starting position with the pos and scale
-		else
-		{
-			buildWallSegment(rStart, p1.second, 0, rScale, 1, /*door height*/3);
-			//buildWallSegment(r, p1.second, 0, 1, 1, 0.2);
-			rScale = 0;
-			rStart = r + 1;
-		}
-	}
-
-	//builds the final segment
-	//if there were no doors, builds the whole wall
-	buildWallSegment(rStart, p1.second, 0, rScale, 1, /*door height*/3);
-
-	//blocks off the entire final segment
-	for (int r = rStart; r < rScale; r++)
-	{
-		blocked.insert(std::make_pair(r, p1.second));
+	case SpawnKind::Enemy:
+		return enemy;
+	case SpawnKind::Chest:
+		return chest;
+	default:
+		return exit;
 	}
 }
 
-void ARoom::buildHorizontalWall(std::pair<int, int>& p1, std::pair<int, int>& p2)
+void ARoom::build(UWorld* world, const RoomPlan& plan, const FloorDelta& delta, const bool spawnActors,
+                  EnemyCrowd* crowd)
 {
-	int col = std::min(p1.second, p2.second) + 1;
-	int cScale = 0;
-	int cStart = col;
-	//loops over the col
-	//scale & loop begins at 1 and row because corners are never doors
-	for (int c = col; c < std::max(p1.second, p2.second); c++)
+	//walls, overheads and the ceiling go in as one batch instead of one render state update per cube
 	{
-		//if there is no door then increase the length of the wall segment
-		unless(room.getDoors().contains({p1.first, c}))
-		{
-			cScale++;
-			blocked.insert(std::make_pair(p1.first, c));
-		}
-		//if there is a door then build a segment from the starting position with the pos and scale
-		else
+		RELICS_SCOPE(BuildWalls);
+		TArray<FTransform> transforms;
+		transforms.Reserve(static_cast<int32>(plan.segments.size()));
+		for (const auto& segment : plan.segments)
 		{
-			buildWallSegment(p1.first, cStart, 0, 1, cScale, /*door height*/3);
-			//buildWallSegment(p1.first, c, 0, 1, 1, 0.2);
-			cScale = 0;
-			cStart = c + 1;
+			transforms.Add(getSegmentTransform(segment));
 		}
-	}
-	//builds the final segment
-	//if there were no doors, builds the whole wall
-	if (cScale > 0)
-	{
-		buildWallSegment(p1.first, cStart, 0, 1, cScale, /*door height*/3);
+		blocks->AddInstances(transforms, false);
+		RELICS_COUNT(InstancesAdded, transforms.Num());
 	}
 
-	//blocks off the entire final segment
-	for (int c = cStart; c < cScale; c++)
-	{
-		blocked.insert(std::make_pair(p1.first, c));
-	}
-}
-
-void ARoom::buildOverheads()
-{
-	int r1 = -1;
-	int c1 = -1;
-	int r2 = height;
-	int c2 = width;
-	unsigned int doorHeight = 3;
-	unsigned int zScale = alt - doorHeight;
-
-	//builds four overhead walls
-	buildWallSegment(r1, c1, doorHeight, height + 2, 1, zScale);
-	buildWallSegment(r1, c2, doorHeight, height + 2, 1, zScale);
-	//rows is increased and width is decreased so that overhead walls do not overlap
-	buildWallSegment(r1, c1 + 1, doorHeight, 1, width, zScale);
-	buildWallSegment(r2, c1 + 1, doorHeight, 1, width, zScale);
-}
-
-void ARoom::buildWallSegment(float r, float c, float alty, float rScale,
-                             float cScale, float zScale)
-{
-	if (rScale == 0 || cScale == 0 || zScale == 0)
+	unless(spawnActors)
 	{
+		enemies.assign(plan.spawns.size(), nullptr);
 		return;
 	}
 
-	FMatrix transformMatrix = FMatrix(
-		FPlane(rScale * 1.0f, 0.0f, 0.0f, 0.0f),
-		FPlane(0.0f, cScale * 1.0f, 0.0f, 0.0f),
-		FPlane(0.0f, 0.0f, zScale * 1.0f, 0.0f),
-		FPlane(r * 100.0f, c * 100.0f, alty * 100.0f, 1.0f)
-	);
-
-	blocks->AddInstance(FTransform(transformMatrix));
-}
+	FVector spawnPos = GetActorLocation();
 
-FVector ARoom::getRandomValidPosition()
-{
-	// Try random attempts first (faster if map is mostly open)
-	const int maxAttempts = 1000;
-	for (int attempt = 0; attempt < maxAttempts; ++attempt)
+	for (size_t slot = 0; slot < plan.spawns.size(); slot++)
 	{
-		int x = rg.getRandom(0, width);
-		int y = rg.getRandom(0, height);
-		std::pair<int, int> candidate = {x, y};
-		if (blocked.find(candidate) == blocked.end())
+		const SpawnPoint& spawn = plan.spawns[slot];
+		const bool consumed = delta.test(index, static_cast<int>(slot));
+		//dead enemies stay dead, the slot keeps its place so later slots line up with the delta
+		if (consumed && spawn.kind == SpawnKind::Enemy)
 		{
-			return FVector(x * 100.f, y * 100.f, 0.f);
+			enemies.push_back(nullptr);
+			continue;
 		}
-	}
 
-	// Fallback: build list of valid positions
-	std::vector<std::pair<int, int>> validPoints;
-	for (uint32 x = 0; x <= width; ++x)
-	{
-		for (uint32 y = 0; y <= height; ++y)
+		FVector result = FVector(spawnPos.X + spawn.x, spawnPos.Y + spawn.y, 0.f);
+		if (crowd && spawn.kind == SpawnKind::Enemy)
 		{
-			std::pair<int, int> p = {x, y};
-			if (blocked.find(p) == blocked.end())
-			{
-				validPoints.push_back(p);
-			}
+			crowd->add(index, static_cast<int>(slot), result.X / 100.f, result.Y / 100.f, 0.f);
+			enemies.push_back(nullptr);
+			continue;
 		}
-	}
-
-	auto chosen = validPoints[rg.getRandom(0, static_cast<int>(validPoints.size()) - 1)];
-	return FVector(chosen.first * 100.f, chosen.second * 100.f, 0.f);
-}
-
-void ARoom::build(UWorld* world)
-{
-	//builds the ceiling
-	buildWallSegment(0, 0, alt - 0.2, height, width, 0.2);
-
-	//builds the walls
-	buildOverheads();
-	buildWalls();
-
-	FVector spawnPos = GetActorLocation();
-
-	std::vector classes = {enemy, chest};
-
-	if (rg.getRandom(0, 10) > 8)
-	{
-		classes.push_back(exit);
-	}
 
-	for (auto classToSpawn : classes)
-	{
-		FVector offset = getRandomValidPosition();
-		FVector result = FVector(spawnPos.X + offset.X, spawnPos.Y + offset.Y, 0.f);
-
-		enemies.push_back(spawnActor(world, classToSpawn, &result));
+		AActor* spawned = spawnActor(world, getSpawnClass(spawn.kind), &result);
+		if (consumed && spawned && spawned->Implements<UDungeonSlotActor>())
+		{
+			IDungeonSlotActor::Execute_restoreConsumed(spawned);
+		}
+		enemies.push_back(spawned);
 	}
 }
 
 AActor* ARoom::spawnActor(UWorld* world, UClass* actorType, FVector* location)
 {
+	RELICS_SCOPE(SpawnActor);
 	TArray<AActor*> tempEnemies;
 
 	float spawnAlt = 0;
@@ -223,6 +103,7 @@ AActor* ARoom::spawnActor(UWorld* world, UClass* actorType, FVector* location)
 	if (spawnedEnemy)
 	{
 		UGameplayStatics::FinishSpawningActor(spawnedEnemy, spawnTransform);
+		RELICS_COUNT(ActorsSpawned, 1);
 
 		return spawnedEnemy;
 	}
@@ -231,6 +112,31 @@ AActor* ARoom::spawnActor(UWorld* world, UClass* actorType, FVector* location)
 	return nullptr;
 }
 
+void ARoom::bindActor(const int32 slot, AActor* actor)
+{
+	if (slot >= 0 && slot < static_cast<int32>(enemies.size()))
+	{
+		enemies[slot] = actor;
+	}
+}
+
+AActor* ARoom::spawnEnemy(const int32 slot, const FVector& location, const float yaw)
+{
+	FVector spawnLocation = location;
+	AActor* spawned = spawnActor(GetWorld(), enemy, &spawnLocation);
+	if (spawned)
+	{
+		spawned->SetActorRotation(FRotator(0.f, yaw, 0.f));
+	}
+	bindActor(slot, spawned);
+	return spawned;
+}
+
+void ARoom::setRoomVisible(const bool visible)
+{
+	blocks->SetVisibility(visible);
+}
+
 void ARoom::clearActors()
 {
 	/*
@@ -247,7 +153,7 @@ void ARoom::clearActors()
 }
 
 ARoom::ARoom()
-	: constructed(false), enemies(std::vector<AActor*>()),
+	: constructed(false), enemies(std::vector<AActor*>()), index(-1),
 	  enemy(nullptr), chest(nullptr), exit(nullptr), width(0), height(0)
 {
 	PrimaryActorTick.bCanEverTick = false;
@@ -275,16 +181,18 @@ ARoom::~ARoom()
 	clearActors();
 }
 
-void ARoom::init(const RoomImpl& roomRef, RandomGenerator& rgRef, UClass* enemyRef, UClass* chestRef, UClass* exitRef)
+void ARoom::init(const RoomPlan& plan, const int32 roomIndex, const FloorDelta& delta, UClass* enemyRef,
+                 UClass* chestRef, UClass* exitRef, const bool spawnActors, EnemyCrowd* crowd)
 {
+	RELICS_SCOPE(RoomInit);
+	index = roomIndex;
 	enemy = enemyRef;
 	chest = chestRef;
 	exit = exitRef;
-	room = roomRef;
-	rg = rgRef;
-	width = roomRef.getWidth();
-	height = roomRef.getHeight();
-	alt = rgRef.getRandom(4, 7);
+	room = plan.room;
+	width = plan.room.getWidth();
+	height = plan.room.getHeight();
+	alt = plan.alt;
 
 	//moved from OnConstruction
 	if (room.getDoors().size() == 0)
@@ -292,13 +200,11 @@ void ARoom::init(const RoomImpl& roomRef, RandomGenerator& rgRef, UClass* enemyR
 		return;
 	}
 
-	UE_LOG(LogTemp, Warning, TEXT("Pre-Room-GetWorld"));
 	UWorld* world = GetWorld();
-	UE_LOG(LogTemp, Warning, TEXT("Post-Room-GetWorld"));
 
 	blocks->ClearInstances();
 
-	build(world);
+	build(world, plan, delta, spawnActors, crowd);
 }
 
 void ARoom::BeginDestroy()
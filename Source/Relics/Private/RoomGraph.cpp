@@ -0,0 +1,229 @@
+#include "RoomGraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_map>
+
+RoomGraph::RoomGraph()
+	: size(0), buckets(0)
+{
+}
+
+void RoomGraph::build(const RoomList& rooms, const RoomIdLayer& ids, const int gap)
+{
+	//copied rather than shared, ids may live in a generation arena that is about to be reset
+	roomIds = ids;
+	size = roomIds.getSize();
+	bounds.clear();
+	doors.clear();
+	firstDoor.clear();
+	links.clear();
+	adjacency.assign(rooms.size(), {});
+
+	for (size_t i = 0; i < rooms.size(); i++)
+	{
+		const RoomImpl& room = rooms[i];
+		const int row = static_cast<int>(room.getRow());
+		const int col = static_cast<int>(room.getCol());
+		bounds.push_back({row, col, static_cast<int>(room.getWidth()), static_cast<int>(room.getHeight())});
+
+		firstDoor.push_back(static_cast<int>(doors.size()));
+		for (const auto& door : room.getDoors())
+		{
+			doors.push_back({static_cast<int>(i), door.first + row, door.second + col});
+		}
+	}
+	firstDoor.push_back(static_cast<int>(doors.size()));
+
+	//rooms sit at least gap cells apart, so facing doors are within a few gaps of each other
+	const int reach = std::max(1, gap * 3);
+	const int cells = size / reach + 1;
+	std::vector<std::vector<int>> doorBuckets(static_cast<size_t>(cells) * cells);
+	for (size_t d = 0; d < doors.size(); d++)
+	{
+		const int br = std::clamp(doors[d].r / reach, 0, cells - 1);
+		const int bc = std::clamp(doors[d].c / reach, 0, cells - 1);
+		doorBuckets[br * cells + bc].push_back(static_cast<int>(d));
+	}
+
+	std::unordered_map<uint64_t, int> pairs;
+	for (size_t d = 0; d < doors.size(); d++)
+	{
+		const DoorCell& door = doors[d];
+		const int br = std::clamp(door.r / reach, 0, cells - 1);
+		const int bc = std::clamp(door.c / reach, 0, cells - 1);
+		for (int i = std::max(0, br - 1); i <= std::min(cells - 1, br + 1); i++)
+		{
+			for (int j = std::max(0, bc - 1); j <= std::min(cells - 1, bc + 1); j++)
+			{
+				for (const int e : doorBuckets[i * cells + j])
+				{
+					const DoorCell& other = doors[e];
+					if (other.room <= door.room)
+					{
+						continue;
+					}
+					const int distance = std::abs(door.r - other.r) + std::abs(door.c - other.c);
+					if (distance > reach)
+					{
+						continue;
+					}
+					const uint64_t key = static_cast<uint64_t>(door.room) << 32 | static_cast<uint32_t>(other.room);
+					auto found = pairs.find(key);
+					if (found == pairs.end())
+					{
+						pairs.emplace(key, static_cast<int>(links.size()));
+						links.push_back({door.room, other.room, static_cast<int>(d), e, distance});
+					}
+					else if (distance < links[found->second].distance)
+					{
+						links[found->second] = {door.room, other.room, static_cast<int>(d), e, distance};
+					}
+				}
+			}
+		}
+	}
+	//bucket order depends on door order only, but keep links sorted so every consumer sees the same graph
+	std::sort(links.begin(), links.end(), [](const RoomLink& x, const RoomLink& y)
+	{
+		return x.a != y.a ? x.a < y.a : x.b < y.b;
+	});
+	for (size_t l = 0; l < links.size(); l++)
+	{
+		adjacency[links[l].a].push_back(static_cast<int>(l));
+		adjacency[links[l].b].push_back(static_cast<int>(l));
+	}
+
+	buckets = size / BUCKET + 1;
+	roomBuckets.assign(static_cast<size_t>(buckets) * buckets, {});
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		const RoomBounds& b = bounds[i];
+		for (int r = std::max(0, b.row / BUCKET); r <= std::min(buckets - 1, (b.row + b.height) / BUCKET); r++)
+		{
+			for (int c = std::max(0, b.col / BUCKET); c <= std::min(buckets - 1, (b.col + b.width) / BUCKET); c++)
+			{
+				roomBuckets[r * buckets + c].push_back(static_cast<int>(i));
+			}
+		}
+	}
+}
+
+int RoomGraph::getRoomCount() const
+{
+	return static_cast<int>(bounds.size());
+}
+
+const RoomBounds& RoomGraph::getBounds(const int room) const
+{
+	return bounds[room];
+}
+
+const DoorCell* RoomGraph::doorsBegin(const int room) const
+{
+	return doors.data() + firstDoor[room];
+}
+
+const DoorCell* RoomGraph::doorsEnd(const int room) const
+{
+	return doors.data() + firstDoor[room + 1];
+}
+
+const std::vector<DoorCell>& RoomGraph::getDoors() const
+{
+	return doors;
+}
+
+const std::vector<RoomLink>& RoomGraph::getLinks() const
+{
+	return links;
+}
+
+const std::vector<int>& RoomGraph::getLinksOf(const int room) const
+{
+	return adjacency[room];
+}
+
+const RoomIdLayer& RoomGraph::getRoomIds() const
+{
+	return roomIds;
+}
+
+int RoomGraph::findRoom(const float r, const float c) const
+{
+	if (r < 0 || c < 0)
+	{
+		return -1;
+	}
+	return roomIds.get(static_cast<int>(r), static_cast<int>(c));
+}
+
+void RoomGraph::roomsNear(const float r, const float c, const float radius, std::vector<int>& out) const
+{
+	if (!buckets)
+	{
+		return;
+	}
+	const int r0 = std::clamp(static_cast<int>((r - radius) / BUCKET), 0, buckets - 1);
+	const int r1 = std::clamp(static_cast<int>((r + radius) / BUCKET), 0, buckets - 1);
+	const int c0 = std::clamp(static_cast<int>((c - radius) / BUCKET), 0, buckets - 1);
+	const int c1 = std::clamp(static_cast<int>((c + radius) / BUCKET), 0, buckets - 1);
+	const size_t first = out.size();
+	for (int i = r0; i <= r1; i++)
+	{
+		for (int j = c0; j <= c1; j++)
+		{
+			for (const int room : roomBuckets[i * buckets + j])
+			{
+				const RoomBounds& b = bounds[room];
+				const float dr = std::max({0.f, b.row - r, r - (b.row + b.height)});
+				const float dc = std::max({0.f, b.col - c, c - (b.col + b.width)});
+				if (dr * dr + dc * dc <= radius * radius)
+				{
+					out.push_back(room);
+				}
+			}
+		}
+	}
+	//large rooms sit in several buckets
+	std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+	out.erase(std::unique(out.begin() + static_cast<std::ptrdiff_t>(first), out.end()), out.end());
+}
+
+void RoomGraph::hopsFrom(const int room, const int maxHops, std::vector<int>& hops) const
+{
+	hopsFrom(std::vector<int>{room}, maxHops, hops);
+}
+
+void RoomGraph::hopsFrom(const std::vector<int>& rooms, const int maxHops, std::vector<int>& hops) const
+{
+	hops.assign(bounds.size(), -1);
+	std::vector<int> frontier;
+	std::vector<int> next;
+	for (const int room : rooms)
+	{
+		if (room >= 0 && room < static_cast<int>(bounds.size()) && hops[room] < 0)
+		{
+			hops[room] = 0;
+			frontier.push_back(room);
+		}
+	}
+	for (int depth = 1; depth <= maxHops && !frontier.empty(); depth++)
+	{
+		next.clear();
+		for (const int current : frontier)
+		{
+			for (const int l : adjacency[current])
+			{
+				const int other = links[l].a == current ? links[l].b : links[l].a;
+				if (hops[other] < 0)
+				{
+					hops[other] = depth;
+					next.push_back(other);
+				}
+			}
+		}
+		std::swap(frontier, next);
+	}
+}
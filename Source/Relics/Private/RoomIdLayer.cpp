@@ -0,0 +1,88 @@
+#include "RoomIdLayer.h"
+
+#include <algorithm>
+
+RoomIdLayer::RoomIdLayer()
+	: size(0)
+{
+}
+
+RoomIdLayer::RoomIdLayer(const int size, std::pmr::memory_resource* memory)
+	: size(size), cells(static_cast<size_t>(size) * size, NONE, memory)
+{
+}
+
+void RoomIdLayer::stamp(const RoomImpl& room, const int index)
+{
+	const auto& walls = room.getWalls();
+	if (walls.empty() || index < 0 || index >= MAX_ROOMS)
+	{
+		return;
+	}
+	const int row = static_cast<int>(room.getRow());
+	const int col = static_cast<int>(room.getCol());
+	const auto id = static_cast<uint16_t>(index);
+	//outlines have a handful of corners, so the crossings of a row fit on the stack
+	int crossings[32];
+
+	//the outline is rectilinear, so each row is filled between pairs of the vertical edges it crosses
+	for (int r = 0; r < static_cast<int>(room.getHeight()); r++)
+	{
+		int count = 0;
+		for (size_t i = 0, j = walls.size() - 1; i < walls.size() && count < 32; j = i++)
+		{
+			if (walls[i].second == walls[j].second && std::min(walls[i].first, walls[j].first) <= r
+				&& r < std::max(walls[i].first, walls[j].first))
+			{
+				crossings[count++] = walls[i].second;
+			}
+		}
+		std::sort(crossings, crossings + count);
+		for (int k = 0; k + 1 < count; k += 2)
+		{
+			const int cr = r + row;
+			if (cr < 0 || cr >= size)
+			{
+				continue;
+			}
+			const int from = std::max(0, crossings[k] + col);
+			const int to = std::min(size - 1, crossings[k + 1] + col);
+			std::fill(cells.begin() + cr * size + from, cells.begin() + cr * size + to + 1, id);
+		}
+	}
+
+	//the half-open rows above leave out the outline's top edges
+	for (size_t i = 0, j = walls.size() - 1; i < walls.size(); j = i++)
+	{
+		for (int r = std::min(walls[i].first, walls[j].first); r <= std::max(walls[i].first, walls[j].first); r++)
+		{
+			for (int c = std::min(walls[i].second, walls[j].second); c <= std::max(walls[i].second, walls[j].second); c++)
+			{
+				if (r + row >= 0 && r + row < size && c + col >= 0 && c + col < size)
+				{
+					cells[(r + row) * size + c + col] = id;
+				}
+			}
+		}
+	}
+}
+
+int RoomIdLayer::get(const int r, const int c) const
+{
+	if (r < 0 || c < 0 || r >= size || c >= size)
+	{
+		return -1;
+	}
+	const uint16_t id = cells[r * size + c];
+	return id == NONE ? -1 : id;
+}
+
+int RoomIdLayer::getSize() const
+{
+	return size;
+}
+
+size_t RoomIdLayer::getMemoryUsage() const
+{
+	return cells.capacity() * sizeof(uint16_t);
+}
@@ -2,40 +2,17 @@
 
 #include <algorithm>
 
-void RoomImpl::drawLine(const bool isVert, std::pair<int, int>* wall, std::pair<int, int>* next, TwoDArray& grid) const
+void RoomImpl::drawLoop(const CellList& loop, const char ch, TwoDArray& grid) const
 {
-	//char ch = (id % (126 - 33)) + 33;
-	char ch = id % (126 - 48) + 48;
-
-	if (isVert)
+	for (size_t i = 0; i < loop.size(); i++)
 	{
-		int start = std::min(wall->first, next->first);
-		int end = std::max(wall->first, next->first);
-		for (int i = start; i <= end; i++)
+		const auto& a = loop[i];
+		const auto& b = loop[(i + 1) % loop.size()];
+		for (int r = std::min(a.first, b.first); r <= std::max(a.first, b.first); r++)
 		{
-			if (!doors.contains({i, wall->second}))
-			{
-				grid.set(i + row, wall->second + col, ch);
-			}
-			else
+			for (int c = std::min(a.second, b.second); c <= std::max(a.second, b.second); c++)
 			{
-				grid.set(i + row, wall->second + col, ' ');
-			}
-		}
-	}
-	else
-	{
-		int start = std::min(wall->second, next->second);
-		int end = std::max(wall->second, next->second);
-		for (int j = start; j <= end; j++)
-		{
-			if (!doors.contains({wall->first, j}))
-			{
-				grid.set(wall->first + row, j + col, ch);
-			}
-			else
-			{
-				grid.set(wall->first + row, j + col, ' ');
+				grid.set(r + row, c + col, doors.contains({r, c}) ? ' ' : ch);
 			}
 		}
 	}
@@ -52,7 +29,7 @@ void RoomImpl::reshapeL(RandomGenerator& rg)
 	unsigned int c = rg.getRandom(min_size, static_cast<int>(width - 1) - min_size);
 	unsigned int r = rg.getRandom(min_size, static_cast<int>(height - 1) - min_size);
 
-	std::vector<std::pair<int, int>> newWalls;
+	CellList newWalls(walls.get_allocator());
 	if (wall == 0)
 	{
 		newWalls.emplace_back(walls[0]);
@@ -89,7 +66,8 @@ void RoomImpl::reshapeL(RandomGenerator& rg)
 		newWalls.emplace_back(walls[2]);
 		newWalls.emplace_back(walls[3]);
 	}
-	walls = newWalls;
+	walls = std::move(newWalls);
+	shape = RoomShape::L;
 }
 
 void RoomImpl::reshapeU(RandomGenerator& rg)
@@ -112,7 +90,7 @@ void RoomImpl::reshapeU(RandomGenerator& rg)
 		}
 	}
 
-	std::vector<std::pair<int, int>> newWalls;
+	CellList newWalls(walls.get_allocator());
 	if (wall == 0)
 	{
 		unsigned int c = rg.getRandom(0, static_cast<int>(width) - 1 - min_size - min_size) + min_size;
@@ -181,7 +159,66 @@ void RoomImpl::reshapeU(RandomGenerator& rg)
 		newWalls.emplace_back(r, c1);
 		newWalls.emplace_back(walls[3].first, c1);
 	}
-	walls = newWalls;
+	walls = std::move(newWalls);
+	shape = RoomShape::U;
+}
+
+void RoomImpl::reshapeT(RandomGenerator& rg)
+{
+	//notches and the bar at least 3 cells deep, the stem at least 4 wide
+	const int min_size = 3;
+	const int min_stem = 4;
+	const int turns = rg.getRandom(0, 3);
+	//the template is drawn with its stem pointing down the rows, odd turns lay it on its side
+	const int frameHeight = static_cast<int>(turns % 2 ? width : height);
+	const int frameWidth = static_cast<int>(turns % 2 ? height : width);
+	if (frameWidth - 1 < min_size + min_stem + min_size || frameHeight - 1 < min_size + min_size)
+	{
+		return;
+	}
+
+	const int depth = rg.getRandom(min_size, frameHeight - 1 - min_size);
+	const int c1 = rg.getRandom(min_size, frameWidth - 1 - min_size - min_stem);
+	const int c2 = rg.getRandom(c1 + min_stem, frameWidth - 1 - min_size);
+	setOutline(RoomStamps::turn(RoomStamps::tee(frameHeight, frameWidth, depth, c1, c2),
+	                            static_cast<int>(height), static_cast<int>(width), turns));
+	shape = RoomShape::T;
+}
+
+void RoomImpl::reshapeCross(RandomGenerator& rg)
+{
+	const int min_size = 3;
+	const int min_bar = 4;
+	const int h = static_cast<int>(height);
+	const int w = static_cast<int>(width);
+	if (std::min(h, w) - 1 < min_size + min_bar + min_size)
+	{
+		return;
+	}
+
+	const int r1 = rg.getRandom(min_size, h - 1 - min_size - min_bar);
+	const int r2 = rg.getRandom(r1 + min_bar, h - 1 - min_size);
+	const int c1 = rg.getRandom(min_size, w - 1 - min_size - min_bar);
+	const int c2 = rg.getRandom(c1 + min_bar, w - 1 - min_size);
+	setOutline(RoomStamps::cross(h, w, r1, r2, c1, c2));
+	shape = RoomShape::Cross;
+}
+
+void RoomImpl::reshapeRounded(RandomGenerator& rg)
+{
+	//a straight stretch of at least two cells is left between the corners of every side
+	const int largest = std::min<int>(RoomStamps::MAX_RADIUS, (static_cast<int>(std::min(width, height)) - 2) / 2);
+	if (largest < 2)
+	{
+		return;
+	}
+	setOutline(RoomStamps::rounded(static_cast<int>(height), static_cast<int>(width), rg.getRandom(2, largest)));
+	shape = RoomShape::Rounded;
+}
+
+void RoomImpl::setOutline(const RoomStamps::Outline& outline)
+{
+	walls.assign(outline.corners.begin(), outline.corners.begin() + outline.count);
 }
 
 void RoomImpl::reshapeO(RandomGenerator& rg)
@@ -203,7 +240,7 @@ void RoomImpl::reshapeO(RandomGenerator& rg)
 		}
 	}
 
-	std::vector<std::pair<int, int>> newWalls;
+	CellList newWalls(walls.get_allocator());
 
 	unsigned int c1 = rg.getRandom(0, static_cast<int>(width) - 1 - min_size - min_size - min_interior);
 	unsigned int c2 = rg.getRandom(static_cast<int>(c1) + min_interior,
@@ -221,42 +258,29 @@ void RoomImpl::reshapeO(RandomGenerator& rg)
 	newWalls.emplace_back(r2, c2);
 	newWalls.emplace_back(r1, c2);
 
-	interior_walls = newWalls;
+	interior_walls = std::move(newWalls);
+	shape = RoomShape::O;
 }
 
 void RoomImpl::addDoors(RandomGenerator& rg)
 {
-	bool isVert = true;
-	bool hasDoor = false;
-	std::pair<int, int>* wall = nullptr;
-	for (auto& next : walls)
-	{
-		if (wall)
-		{
-			addDoorToWall(rg, isVert, next, wall, hasDoor);
-			isVert = !isVert;
-			hasDoor = false;
-		}
-		wall = &next;
-	}
-	addDoorToWall(rg, isVert, walls[0], &walls[walls.size() - 1], hasDoor);
-	isVert = !isVert;
-	hasDoor = false;
+	addDoorsToLoop(rg, walls);
+	addDoorsToLoop(rg, interior_walls);
+}
 
-	unless(interior_walls.empty())
+void RoomImpl::addDoorsToLoop(RandomGenerator& rg, CellList& loop)
+{
+	//every loop starts on a vertical edge and alternates from there, its last corner closes back to the first
+	//a rounded stamp only forces doors on its straight sides, the stair steps of its corners are off the bounding box
+	bool isVert = true;
+	for (size_t i = 0; i < loop.size(); i++)
 	{
-		for (auto& next : interior_walls)
-		{
-			if (wall)
-			{
-				addDoorToWall(rg, isVert, next, wall, hasDoor);
-				isVert = !isVert;
-				hasDoor = false;
-			}
-			wall = &next;
-		}
+		const int line = isVert ? loop[i].second : loop[i].first;
+		const int last = static_cast<int>(isVert ? width : height) - 1;
+		const bool isStep = shape == RoomShape::Rounded && line != 0 && line != last;
+		addDoorToWall(rg, isVert, loop[(i + 1) % loop.size()], &loop[i], isStep);
+		isVert = !isVert;
 	}
-	addDoorToWall(rg, isVert, walls[0], &walls[walls.size() - 1], hasDoor);
 }
 
 void RoomImpl::addDoorToWall(RandomGenerator& rg, bool isVert, std::pair<int, int> next, std::pair<int, int>* wall,
@@ -283,34 +307,42 @@ void RoomImpl::addDoorToWall(RandomGenerator& rg, bool isVert, std::pair<int, in
 
 void RoomImpl::draw(TwoDArray& grid)
 {
-	bool isVert = true;
-	std::pair<int, int>* wall = nullptr;
-	for (auto& next : walls)
+	//char ch = (id % (126 - 33)) + 33;
+	const char ch = static_cast<char>(id % (126 - 48) + 48);
+
+	unless(RoomStamp::fits(static_cast<int>(height), static_cast<int>(width)))
 	{
-		if (wall)
-		{
-			drawLine(isVert, wall, &next, grid);
-			isVert = !isVert;
-		}
-		wall = &next;
+		drawLoop(walls, ch, grid);
+		drawLoop(interior_walls, ch, grid);
+		return;
 	}
-	drawLine(isVert, wall, &walls[0], grid);
 
-	unless(interior_walls.empty())
+	//every row of the stamp is written in one go
+	const RoomStamp stamp = getStamp();
+	for (int r = 0; r < stamp.height; r++)
 	{
-		for (auto& next : interior_walls)
-		{
-			if (wall)
-			{
-				drawLine(isVert, wall, &next, grid);
-				isVert = !isVert;
-			}
-			wall = &next;
-		}
-		drawLine(isVert, wall, &interior_walls[0], grid);
+		grid.drawRow(r + static_cast<int>(row), static_cast<int>(col), stamp.walls[r], ch, stamp.doors[r], ' ');
 	}
 }
 
+RoomStamp RoomImpl::getStamp() const
+{
+	//both outlines and the doors go into one stamp
+	RoomStamp stamp;
+	stamp.height = static_cast<int>(height);
+	stamp.width = static_cast<int>(width);
+	RoomStamps::trace(walls.begin(), walls.end(), stamp);
+	RoomStamps::trace(interior_walls.begin(), interior_walls.end(), stamp);
+	RoomStamps::crossings(walls.begin(), walls.end(), stamp);
+	RoomStamps::crossings(interior_walls.begin(), interior_walls.end(), stamp);
+	RoomStamps::fillFloor(stamp);
+	for (const auto& [r, c] : doors)
+	{
+		stamp.doors[r] |= uint64_t(1) << c;
+	}
+	return stamp;
+}
+
 unsigned int RoomImpl::getId() const
 {
 	return id;
@@ -336,46 +368,105 @@ unsigned int RoomImpl::getHeight() const
 	return height;
 }
 
-std::set<std::pair<int, int>>& RoomImpl::getDoors()
+RoomShape RoomImpl::getShape() const
+{
+	return shape;
+}
+
+CellSet& RoomImpl::getDoors()
+{
+	return doors;
+}
+
+const CellSet& RoomImpl::getDoors() const
 {
 	return doors;
 }
 
-std::vector<std::pair<int, int>>& RoomImpl::getWalls()
+CellList& RoomImpl::getWalls()
+{
+	return walls;
+}
+
+const CellList& RoomImpl::getWalls() const
 {
 	return walls;
 }
 
-std::vector<std::pair<int, int>>& RoomImpl::getInteriorWalls()
+CellList& RoomImpl::getInteriorWalls()
+{
+	return interior_walls;
+}
+
+const CellList& RoomImpl::getInteriorWalls() const
 {
 	return interior_walls;
 }
 
-RoomImpl::RoomImpl(int id, int row, int col, int width, int height, RandomGenerator& rg) :
-	id(id), row(row), col(col), width(width), height(height),
-	walls({{0, 0}, {height - 1, 0}, {height - 1, width - 1}, {0, width - 1}})
+RoomImpl::RoomImpl(int id, int row, int col, int width, int height, RandomGenerator& rg,
+                   const allocator_type& allocator) :
+	RoomImpl(id, row, col, width, height, allocator)
+{
+	if (width >= 3 && height >= 3)
+	{
+		reshape(rg);
+		addDoors(rg);
+	}
+}
+
+RoomImpl::RoomImpl(int id, int row, int col, int width, int height, const allocator_type& allocator) :
+	id(id), row(row), col(col), width(width), height(height), shape(RoomShape::Box),
+	walls({{0, 0}, {height - 1, 0}, {height - 1, width - 1}, {0, width - 1}}, allocator),
+	interior_walls(allocator), doors(allocator)
+{
+}
+
+void RoomImpl::reshape(RandomGenerator& rg)
 {
 	if (width >= 3 && height >= 3)
 	{
 		int chance = rg.getRandom(0, 100);
-		if (chance > 75)
+		if (chance > 85)
 		{
 			reshapeL(rg);
 		}
-		else if (chance > 50)
+		else if (chance > 70)
 		{
 			reshapeU(rg);
 		}
-		else if (chance > 35)
+		else if (chance > 58)
 		{
 			reshapeO(rg);
 		}
-
-		addDoors(rg);
+		else if (chance > 46)
+		{
+			reshapeT(rg);
+		}
+		else if (chance > 36)
+		{
+			reshapeCross(rg);
+		}
+		else if (chance > 24)
+		{
+			reshapeRounded(rg);
+		}
 	}
 }
 
 RoomImpl::RoomImpl()
-	: id(0), row(0), col(0), width(0), height(0)
+	: id(0), row(0), col(0), width(0), height(0), shape(RoomShape::Box)
+{
+}
+
+RoomImpl::RoomImpl(const RoomImpl& other, const allocator_type& allocator)
+	: id(other.id), row(other.row), col(other.col), width(other.width), height(other.height), shape(other.shape),
+	  walls(other.walls, allocator), interior_walls(other.interior_walls, allocator), doors(other.doors, allocator)
+{
+}
+
+RoomImpl::RoomImpl(RoomImpl&& other, const allocator_type& allocator)
+	: id(other.id), row(other.row), col(other.col), width(other.width), height(other.height), shape(other.shape),
+	  walls(std::move(other.walls), allocator), interior_walls(std::move(other.interior_walls), allocator),
+	  doors(std::move(other.doors), allocator)
 {
 }
@@ -0,0 +1,377 @@
+#include "RoomInterior.h"
+
+#include <array>
+#include <bit>
+
+namespace
+{
+	using Tile = RoomInterior::Tile;
+
+	constexpr int TILE_COUNT = RoomInterior::TILE_COUNT;
+	constexpr int CHUNKS = (TILE_COUNT + 7) / 8;
+	constexpr uint64_t ALL_TILES = (uint64_t(1) << TILE_COUNT) - 1;
+	//storage only stands along the walls and furniture only away from them
+	constexpr uint64_t ALONG_WALLS = 1 << Tile::Floor | 1 << Tile::Crate | 1 << Tile::Barrel;
+	constexpr uint64_t AWAY_FROM_WALLS = 1 << Tile::Floor | 1 << Tile::Pillar | 1 << Tile::Table | 1 << Tile::Chair
+		| 1 << Tile::Rug;
+
+	constexpr std::array<int, TILE_COUNT> WEIGHTS = {48, 0, 6, 5, 1, 3, 8, 4};
+
+	//directions 0 and 1 step down and up the rows, 2 and 3 along the columns
+	constexpr int ROW_STEPS[4] = {1, -1, 0, 0};
+	constexpr int COL_STEPS[4] = {0, 0, 1, -1};
+
+	constexpr bool isStorage(const int tile)
+	{
+		return tile == Tile::Crate || tile == Tile::Barrel;
+	}
+
+	constexpr bool isSeating(const int tile)
+	{
+		return tile == Tile::Table || tile == Tile::Chair || tile == Tile::Rug;
+	}
+
+	//whether b may sit next to a in direction dir, asked both ways round so the rules stay symmetric
+	constexpr bool allowsOneWay(const int a, const int b, const int dir)
+	{
+		if (a == Tile::Floor)
+		{
+			return true;
+		}
+		if (a == Tile::Wall)
+		{
+			return b == Tile::Wall || isStorage(b);
+		}
+		if (isStorage(a))
+		{
+			return isStorage(b);
+		}
+		if (a == Tile::Table && b == Tile::Table)
+		{
+			//tables only line up into long ones along the columns
+			return dir >= 2;
+		}
+		if (a == Tile::Chair && b == Tile::Chair)
+		{
+			return false;
+		}
+		return isSeating(a) && isSeating(b);
+	}
+
+	constexpr bool allows(const int a, const int b, const int dir)
+	{
+		return allowsOneWay(a, b, dir) || allowsOneWay(b, a, dir ^ 1);
+	}
+
+	//SUPPORT[dir][chunk][byte] is every tile allowed in direction dir of any tile in that byte of a domain
+	using SupportTable = std::array<std::array<std::array<uint64_t, 256>, CHUNKS>, 4>;
+
+	constexpr SupportTable makeSupport()
+	{
+		SupportTable table{};
+		for (int dir = 0; dir < 4; dir++)
+		{
+			for (int chunk = 0; chunk < CHUNKS; chunk++)
+			{
+				for (int byte = 0; byte < 256; byte++)
+				{
+					uint64_t allowed = 0;
+					for (int bit = 0; bit < 8; bit++)
+					{
+						const int a = chunk * 8 + bit;
+						if (a >= TILE_COUNT || !(byte >> bit & 1))
+						{
+							continue;
+						}
+						for (int b = 0; b < TILE_COUNT; b++)
+						{
+							if (allows(a, b, dir))
+							{
+								allowed |= uint64_t(1) << b;
+							}
+						}
+					}
+					table[dir][chunk][byte] = allowed;
+				}
+			}
+		}
+		return table;
+	}
+
+	constexpr SupportTable SUPPORT = makeSupport();
+
+	static_assert(SUPPORT[0][0][1 << Tile::Floor] == ALL_TILES);
+	static_assert(SUPPORT[2][0][1 << Tile::Table] & 1 << Tile::Table);
+	static_assert(!(SUPPORT[0][0][1 << Tile::Table] & 1 << Tile::Table));
+	static_assert(!(SUPPORT[1][0][1 << Tile::Wall] & 1 << Tile::Pillar));
+
+	uint64_t support(const uint64_t domain, const int dir)
+	{
+		uint64_t allowed = 0;
+		for (int chunk = 0; chunk < CHUNKS; chunk++)
+		{
+			allowed |= SUPPORT[dir][chunk][domain >> (chunk * 8) & 0xFF];
+		}
+		return allowed;
+	}
+
+	//the cells one step from any cell of rows, clipped to the width
+	uint64_t grow(const std::array<uint64_t, RoomStamp::MAX_SIZE>& rows, const int r, const int height)
+	{
+		uint64_t cells = rows[r] | rows[r] << 1 | rows[r] >> 1;
+		if (r > 0)
+		{
+			cells |= rows[r - 1];
+		}
+		if (r + 1 < height)
+		{
+			cells |= rows[r + 1];
+		}
+		return cells;
+	}
+}
+
+RoomInterior::RoomInterior(const RoomStamp& stamp)
+	: height(stamp.height), width(stamp.width), floor(stamp.floor), edges{}, reserved{},
+	  domains(static_cast<size_t>(stamp.height) * stamp.width)
+{
+	std::array<uint64_t, RoomStamp::MAX_SIZE> solid{};
+	for (int r = 0; r < height; r++)
+	{
+		solid[r] = ~floor[r] & RoomStamps::span(0, width - 1);
+	}
+	for (int r = 0; r < height; r++)
+	{
+		edges[r] = grow(solid, r, height) & floor[r];
+		//the floor cell in front of every door stays clear
+		reserved[r] = grow(stamp.doors, r, height) & floor[r];
+	}
+}
+
+void RoomInterior::reserve(const int r, const int c)
+{
+	if (r >= 0 && r < height && c >= 0 && c < width)
+	{
+		reserved[r] |= floor[r] & uint64_t(1) << c;
+	}
+}
+
+void RoomInterior::reset()
+{
+	open.clear();
+	stack.clear();
+	for (int r = 0; r < height; r++)
+	{
+		for (int c = 0; c < width; c++)
+		{
+			const int cell = r * width + c;
+			const bool isFloor = floor[r] >> c & 1;
+			if (isFloor && !(reserved[r] >> c & 1))
+			{
+				domains[cell] = edges[r] >> c & 1 ? ALONG_WALLS : AWAY_FROM_WALLS;
+				open.push_back(cell);
+				continue;
+			}
+			domains[cell] = uint64_t(1) << (isFloor ? Tile::Floor : Tile::Wall);
+			//only the fixed cells constrain anything to begin with
+			stack.push_back(cell);
+		}
+	}
+}
+
+bool RoomInterior::propagate()
+{
+	while (!stack.empty())
+	{
+		const int cell = stack.back();
+		stack.pop_back();
+		const int r = cell / width;
+		const int c = cell % width;
+		for (int dir = 0; dir < 4; dir++)
+		{
+			const int nr = r + ROW_STEPS[dir];
+			const int nc = c + COL_STEPS[dir];
+			if (nr < 0 || nr >= height || nc < 0 || nc >= width)
+			{
+				continue;
+			}
+			const int next = nr * width + nc;
+			const uint64_t narrowed = domains[next] & support(domains[cell], dir);
+			if (narrowed == domains[next])
+			{
+				continue;
+			}
+			if (narrowed == 0)
+			{
+				return false;
+			}
+			domains[next] = narrowed;
+			stack.push_back(next);
+		}
+	}
+	return true;
+}
+
+int RoomInterior::pickCell(RandomGenerator& rg) const
+{
+	//the open cell with the fewest tiles left, ties going to whichever comes first from a random start
+	if (open.empty())
+	{
+		return -1;
+	}
+	const size_t start = static_cast<size_t>(rg.getRandom(0, static_cast<int>(open.size()) - 1));
+	int best = -1;
+	int fewest = TILE_COUNT + 1;
+	for (size_t i = 0; i < open.size(); i++)
+	{
+		const int cell = open[(start + i) % open.size()];
+		const int count = std::popcount(domains[cell]);
+		if (count > 1 && count < fewest)
+		{
+			best = cell;
+			fewest = count;
+			if (count == 2)
+			{
+				break;
+			}
+		}
+	}
+	return best;
+}
+
+void RoomInterior::collapse(const int cell, RandomGenerator& rg)
+{
+	int total = 0;
+	for (uint64_t rest = domains[cell]; rest; rest &= rest - 1)
+	{
+		total += WEIGHTS[std::countr_zero(rest)];
+	}
+	int pick = rg.getRandom(0, total - 1);
+	for (uint64_t rest = domains[cell]; rest; rest &= rest - 1)
+	{
+		const int tile = std::countr_zero(rest);
+		pick -= WEIGHTS[tile];
+		if (pick < 0)
+		{
+			domains[cell] = uint64_t(1) << tile;
+			break;
+		}
+	}
+	stack.push_back(cell);
+}
+
+RoomInterior::Tile RoomInterior::getTile(const int r, const int c) const
+{
+	if (r < 0 || r >= height || c < 0 || c >= width)
+	{
+		return Tile::Wall;
+	}
+	return static_cast<Tile>(std::countr_zero(domains[r * width + c]));
+}
+
+void RoomInterior::seatChairs(std::vector<PropInstance>& props) const
+{
+	for (PropInstance& prop : props)
+	{
+		if (prop.kind != PropKind::Chair)
+		{
+			continue;
+		}
+		prop.yaw = -1.f;
+		for (int dir = 0; dir < 4; dir++)
+		{
+			if (getTile(prop.r + ROW_STEPS[dir], prop.c + COL_STEPS[dir]) == Tile::Table)
+			{
+				constexpr float YAWS[4] = {0.f, 180.f, 90.f, 270.f};
+				prop.yaw = YAWS[dir];
+				break;
+			}
+		}
+	}
+	std::erase_if(props, [](const PropInstance& prop) { return prop.yaw < 0.f; });
+}
+
+bool RoomInterior::isConnected() const
+{
+	//rugs are the only props that can be walked over
+	std::array<uint64_t, RoomStamp::MAX_SIZE> walkable{};
+	std::array<uint64_t, RoomStamp::MAX_SIZE> reached{};
+	int first = -1;
+	for (int r = 0; r < height; r++)
+	{
+		for (int c = 0; c < width; c++)
+		{
+			const Tile tile = getTile(r, c);
+			if (floor[r] >> c & 1 && (tile == Tile::Floor || tile == Tile::Rug))
+			{
+				walkable[r] |= uint64_t(1) << c;
+			}
+		}
+		if (first < 0 && reserved[r])
+		{
+			first = r;
+			reached[r] = reserved[r] & (~reserved[r] + 1);
+		}
+	}
+	if (first < 0)
+	{
+		return true;
+	}
+
+	//a flood fill a row at a time, grown until a sweep changes nothing
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (int r = 0; r < height; r++)
+		{
+			const uint64_t grown = grow(reached, r, height) & walkable[r];
+			if (grown != reached[r])
+			{
+				reached[r] |= grown;
+				changed = true;
+			}
+		}
+	}
+	for (int r = 0; r < height; r++)
+	{
+		if (reserved[r] & ~reached[r])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RoomInterior::solve(RandomGenerator& rg, std::vector<PropInstance>& props)
+{
+	std::vector<PropInstance> placed;
+	for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+	{
+		reset();
+		bool solved = propagate();
+		for (int cell = pickCell(rg); solved && cell >= 0; cell = pickCell(rg))
+		{
+			collapse(cell, rg);
+			solved = propagate();
+		}
+		if (!solved || !isConnected())
+		{
+			continue;
+		}
+
+		placed.clear();
+		for (const int cell : open)
+		{
+			const Tile tile = static_cast<Tile>(std::countr_zero(domains[cell]));
+			if (tile != Tile::Floor && tile != Tile::Wall)
+			{
+				//the prop kinds follow the tiles from Crate on
+				placed.push_back({static_cast<PropKind>(tile - Tile::Crate), cell / width, cell % width, 0.f});
+			}
+		}
+		seatChairs(placed);
+		props.insert(props.end(), placed.begin(), placed.end());
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,367 @@
+#include "RoomPaths.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#include "TaskPool.h"
+
+RoomPaths::RoomPaths()
+	: size(0)
+{
+}
+
+void RoomPaths::build(const RoomGraph& graph, const WallGrid& walls, const std::vector<Corridor>& corridors,
+                      const std::array<std::vector<PropInstance>, PROP_KIND_COUNT>& props)
+{
+	const RoomIdLayer& roomIds = graph.getRoomIds();
+	size = roomIds.getSize();
+	cells.assign(static_cast<size_t>(size) * size, BLOCKED);
+	for (int r = 0; r < size; r++)
+	{
+		for (int c = 0; c < size; c++)
+		{
+			if (roomIds.get(r, c) >= 0 && !walls.isWall(r, c))
+			{
+				cells[r * size + c] = OPEN;
+			}
+		}
+	}
+	for (const auto& corridor : corridors)
+	{
+		for (const auto& [r, c] : corridor.cells)
+		{
+			cells[r * size + c] = OPEN;
+		}
+	}
+	for (int kind = 0; kind < PROP_KIND_COUNT; kind++)
+	{
+		if (static_cast<PropKind>(kind) == PropKind::Rug)
+		{
+			continue;
+		}
+		for (const PropInstance& prop : props[kind])
+		{
+			cells[prop.r * size + prop.c] = BLOCKED;
+		}
+	}
+	const std::vector<DoorCell>& doors = graph.getDoors();
+	portals.clear();
+	for (size_t d = 0; d < doors.size(); d++)
+	{
+		portals.push_back(doors[d].r * size + doors[d].c);
+		cells[portals.back()] = static_cast<int>(d);
+	}
+
+	//every portal walks its clusters once, the walks only read cells so they are spread across the pool
+	const int count = static_cast<int>(portals.size());
+	std::vector<std::vector<PortalEdge>> found(portals.size());
+	std::atomic<int> next(0);
+	TaskPool& pool = TaskPool::shared();
+	pool.parallelFor(std::min(count, static_cast<int>(pool.getThreadCount())), [&](int)
+	{
+		Reach reach;
+		for (int portal = next++; portal < count; portal = next++)
+		{
+			walk(portals[portal], -1, reach);
+			for (const int door : reach.doors)
+			{
+				if (door != portal)
+				{
+					found[portal].push_back({door, reach.g[portals[door]]});
+				}
+			}
+		}
+	});
+
+	firstEdge.clear();
+	edges.clear();
+	for (const auto& list : found)
+	{
+		firstEdge.push_back(static_cast<int>(edges.size()));
+		edges.insert(edges.end(), list.begin(), list.end());
+	}
+	firstEdge.push_back(static_cast<int>(edges.size()));
+}
+
+void RoomPaths::walk(const int cell, const int stopAt, Reach& reach) const
+{
+	const size_t count = static_cast<size_t>(size) * size;
+	//buffers only grow, like the corridor router's
+	if (reach.seen.size() < count)
+	{
+		reach.g.resize(count);
+		reach.parent.resize(count);
+		reach.seen.assign(count, 0);
+		reach.stamp = 0;
+	}
+	if (++reach.stamp == 0)
+	{
+		std::fill(reach.seen.begin(), reach.seen.end(), 0);
+		reach.stamp = 1;
+	}
+	reach.doors.clear();
+	reach.queue.clear();
+	if (cell < 0 || cell >= static_cast<int>(count) || cells[cell] == BLOCKED)
+	{
+		return;
+	}
+
+	reach.seen[cell] = reach.stamp;
+	reach.g[cell] = 0;
+	reach.parent[cell] = -1;
+	reach.queue.push_back(cell);
+	if (cells[cell] >= 0)
+	{
+		reach.doors.push_back(cells[cell]);
+	}
+	for (size_t i = 0; i < reach.queue.size(); i++)
+	{
+		const int current = reach.queue[i];
+		if (current == stopAt)
+		{
+			return;
+		}
+		if (i > 0 && cells[current] >= 0)
+		{
+			continue;
+		}
+		const int r = current / size;
+		const int c = current % size;
+		const int neighbours[4] = {
+			r > 0 ? current - size : -1, r + 1 < size ? current + size : -1, c > 0 ? current - 1 : -1,
+			c + 1 < size ? current + 1 : -1
+		};
+		for (const int step : neighbours)
+		{
+			if (step < 0 || cells[step] == BLOCKED || reach.seen[step] == reach.stamp)
+			{
+				continue;
+			}
+			reach.seen[step] = reach.stamp;
+			reach.g[step] = reach.g[current] + 1;
+			reach.parent[step] = current;
+			reach.queue.push_back(step);
+			if (cells[step] >= 0)
+			{
+				reach.doors.push_back(cells[step]);
+			}
+		}
+	}
+}
+
+int RoomPaths::getCell(const int r, const int c) const
+{
+	if (r < 0 || c < 0 || r >= size || c >= size)
+	{
+		return BLOCKED;
+	}
+	return cells[r * size + c];
+}
+
+int RoomPaths::getPortalCount() const
+{
+	return static_cast<int>(portals.size());
+}
+
+int RoomPaths::getPortalCell(const int portal) const
+{
+	return portals[portal];
+}
+
+const PortalEdge* RoomPaths::edgesBegin(const int portal) const
+{
+	return edges.data() + firstEdge[portal];
+}
+
+const PortalEdge* RoomPaths::edgesEnd(const int portal) const
+{
+	return edges.data() + firstEdge[portal + 1];
+}
+
+int RoomPaths::getSize() const
+{
+	return size;
+}
+
+size_t RoomPaths::getMemoryUsage() const
+{
+	return (cells.capacity() + portals.capacity() + firstEdge.capacity()) * sizeof(int)
+		+ edges.capacity() * sizeof(PortalEdge);
+}
+
+RoomPathfinder::RoomPathfinder(const RoomPaths& paths)
+	: paths(paths), stamp(0)
+{
+}
+
+void RoomPathfinder::trace(const RoomPaths::Reach& reach, const int cell, std::vector<std::pair<int, int>>& out) const
+{
+	const int size = paths.getSize();
+	out.clear();
+	for (int step = cell; step >= 0; step = reach.parent[step])
+	{
+		out.emplace_back(step / size, step % size);
+	}
+	std::reverse(out.begin(), out.end());
+}
+
+bool RoomPathfinder::find(const int fromR, const int fromC, const int toR, const int toC, RoomPath& out)
+{
+	out.length = 0;
+	out.doors.clear();
+	out.head.clear();
+	out.tail.clear();
+	if (paths.getCell(fromR, fromC) == RoomPaths::BLOCKED || paths.getCell(toR, toC) == RoomPaths::BLOCKED)
+	{
+		return false;
+	}
+	const int size = paths.getSize();
+	const int from = fromR * size + fromC;
+	const int to = toR * size + toC;
+
+	//only the clusters around both ends are walked cell by cell, the goal's walk runs backwards from it
+	paths.walk(from, -1, start);
+	paths.walk(to, -1, goal);
+
+	const int count = paths.getPortalCount();
+	if (g.size() < static_cast<size_t>(count))
+	{
+		g.resize(count);
+		parent.resize(count);
+		seen.assign(count, 0);
+		closed.assign(count, 0);
+		goalCost.resize(count);
+		goalSeen.assign(count, 0);
+		stamp = 0;
+	}
+	if (++stamp == 0)
+	{
+		std::fill(seen.begin(), seen.end(), 0);
+		std::fill(closed.begin(), closed.end(), 0);
+		std::fill(goalSeen.begin(), goalSeen.end(), 0);
+		stamp = 1;
+	}
+	for (const int door : goal.doors)
+	{
+		goalSeen[door] = stamp;
+		goalCost[door] = goal.g[paths.getPortalCell(door)];
+	}
+
+	//count stands for the goal itself, reached straight from the start or through the last door on the way
+	const int target = count;
+	int best = start.seen[to] == start.stamp ? start.g[to] : -1;
+	int last = -1;
+	const auto later = [](const Node& a, const Node& b)
+	{
+		return a.f > b.f;
+	};
+	const auto heuristic = [&](const int portal)
+	{
+		const int cell = paths.getPortalCell(portal);
+		return std::abs(cell / size - toR) + std::abs(cell % size - toC);
+	};
+
+	open.clear();
+	if (best >= 0)
+	{
+		open.push_back({best, target});
+	}
+	for (const int door : start.doors)
+	{
+		seen[door] = stamp;
+		g[door] = start.g[paths.getPortalCell(door)];
+		parent[door] = -1;
+		open.push_back({g[door] + heuristic(door), door});
+	}
+	std::make_heap(open.begin(), open.end(), later);
+
+	bool reached = false;
+	while (!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end(), later);
+		const Node node = open.back();
+		open.pop_back();
+		if (node.portal == target)
+		{
+			//a stale goal entry is longer than the best one, which is still waiting in the heap
+			if (node.f == best)
+			{
+				reached = true;
+				break;
+			}
+			continue;
+		}
+		if (closed[node.portal] == stamp)
+		{
+			continue;
+		}
+		closed[node.portal] = stamp;
+
+		if (goalSeen[node.portal] == stamp)
+		{
+			const int total = g[node.portal] + goalCost[node.portal];
+			if (best < 0 || total < best)
+			{
+				best = total;
+				last = node.portal;
+				open.push_back({total, target});
+				std::push_heap(open.begin(), open.end(), later);
+			}
+		}
+		for (const PortalEdge* edge = paths.edgesBegin(node.portal); edge != paths.edgesEnd(node.portal); ++edge)
+		{
+			if (closed[edge->to] == stamp)
+			{
+				continue;
+			}
+			const int step = g[node.portal] + edge->cost;
+			if (seen[edge->to] != stamp || step < g[edge->to])
+			{
+				seen[edge->to] = stamp;
+				g[edge->to] = step;
+				parent[edge->to] = node.portal;
+				open.push_back({step + heuristic(edge->to), edge->to});
+				std::push_heap(open.begin(), open.end(), later);
+			}
+		}
+	}
+	unless(reached)
+	{
+		return false;
+	}
+
+	out.length = best;
+	if (last < 0)
+	{
+		trace(start, to, out.head);
+		return true;
+	}
+	for (int door = last; door >= 0; door = parent[door])
+	{
+		out.doors.push_back(door);
+	}
+	std::reverse(out.doors.begin(), out.doors.end());
+	trace(start, paths.getPortalCell(out.doors.front()), out.head);
+	trace(goal, paths.getPortalCell(last), out.tail);
+	std::reverse(out.tail.begin(), out.tail.end());
+	return true;
+}
+
+bool RoomPathfinder::refine(const RoomPath& path, const int hop, std::vector<std::pair<int, int>>& out)
+{
+	out.clear();
+	if (hop < 0 || hop + 1 >= static_cast<int>(path.doors.size()))
+	{
+		return false;
+	}
+	//the start's buffers are free again once find has returned
+	const int target = paths.getPortalCell(path.doors[hop + 1]);
+	paths.walk(paths.getPortalCell(path.doors[hop]), target, start);
+	if (start.seen[target] != start.stamp)
+	{
+		return false;
+	}
+	trace(start, target, out);
+	return true;
+}
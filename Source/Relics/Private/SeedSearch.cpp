@@ -0,0 +1,192 @@
+#include "SeedSearch.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "GenerationArena.h"
+#include "TaskPool.h"
+
+MinRoomsConstraint::MinRoomsConstraint(const int count)
+	: count(count)
+{
+}
+
+bool MinRoomsConstraint::canStillHold(const GeneratorImpl& layout) const
+{
+	const int placed = static_cast<int>(layout.getRooms().size());
+	if (placed >= count)
+	{
+		return true;
+	}
+	//no room is ever placed smaller than 3 cells a side
+	const int side = std::max(3, layout.getRoomMin());
+	return placed + layout.getOpenCells() / (side * side) >= count;
+}
+
+bool MinRoomsConstraint::holds(const FloorPlan& plan) const
+{
+	return static_cast<int>(plan.getRooms().size()) >= count;
+}
+
+MinRoomSizeConstraint::MinRoomSizeConstraint(const int cells)
+	: cells(cells)
+{
+}
+
+bool MinRoomSizeConstraint::canStillHold(const GeneratorImpl& layout) const
+{
+	//the rooms before the newest were already let through when they were placed
+	const RoomList& rooms = layout.getRooms();
+	return rooms.empty() || static_cast<int>(std::min(rooms.back().getWidth(), rooms.back().getHeight())) >= cells;
+}
+
+bool MinRoomSizeConstraint::holds(const FloorPlan& plan) const
+{
+	return std::ranges::all_of(plan.getRooms(), [this](const RoomPlan& room)
+	{
+		return static_cast<int>(std::min(room.room.getWidth(), room.room.getHeight())) >= cells;
+	});
+}
+
+ExitWithinDoorsConstraint::ExitWithinDoorsConstraint(const int doors)
+	: doors(doors)
+{
+}
+
+bool ExitWithinDoorsConstraint::holds(const FloorPlan& plan) const
+{
+	std::vector<int> hops;
+	plan.getGraph().hopsFrom(0, doors, hops);
+	const auto& rooms = plan.getRooms();
+	for (size_t i = 0; i < rooms.size() && i < hops.size(); i++)
+	{
+		if (hops[i] < 0)
+		{
+			continue;
+		}
+		for (const auto& spawn : rooms[i].spawns)
+		{
+			if (spawn.kind == SpawnKind::Exit)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+SeedSearch::SeedSearch(const int size, const int room_min, const int room_max, const int gap)
+	: size(size), room_min(room_min), room_max(room_max), gap(gap)
+{
+}
+
+void SeedSearch::setBoundary(const BoundaryShape shape)
+{
+	boundary = shape;
+}
+
+void SeedSearch::require(std::unique_ptr<SeedConstraint> constraint)
+{
+	if (constraint)
+	{
+		constraints.push_back(std::move(constraint));
+	}
+}
+
+bool SeedSearch::canStillHold(const GeneratorImpl& layout) const
+{
+	return std::ranges::all_of(constraints, [&layout](const auto& constraint)
+	{
+		return constraint->canStillHold(layout);
+	});
+}
+
+bool SeedSearch::holds(const FloorPlan& plan) const
+{
+	return std::ranges::all_of(constraints, [&plan](const auto& constraint)
+	{
+		return constraint->holds(plan);
+	});
+}
+
+SeedSearchResult SeedSearch::find(const unsigned int first, const int count, const int matches,
+                                  const std::atomic<bool>* cancel) const
+{
+	SeedSearchResult result;
+	if (count <= 0 || matches <= 0)
+	{
+		return result;
+	}
+
+	std::mutex lock;
+	//offsets from first that matched, kept sorted
+	std::vector<int> found;
+	std::atomic<int> next(0);
+	//offsets from here on cannot make it into the answer any more
+	std::atomic<int> limit(count);
+	std::atomic<int> tried(0);
+	std::atomic<int> abandoned(0);
+
+	TaskPool& pool = TaskPool::shared();
+	pool.parallelFor(std::min(count, static_cast<int>(pool.getThreadCount())), [&](int)
+	{
+		GenerationArena arena;
+		for (int offset = next++; offset < limit.load(); offset = next++)
+		{
+			if (cancel && cancel->load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			const unsigned int seed = first + static_cast<unsigned int>(offset);
+			//a seed is also given up when enough lower ones matched while it was being placed
+			const PlacementCheck check = [this, offset, &limit](const GeneratorImpl& layout)
+			{
+				return offset < limit.load(std::memory_order_relaxed) && canStillHold(layout);
+			};
+
+			bool matched;
+			{
+				FloorPlan plan(size, room_min, room_max, gap, seed, &arena);
+				if (boundary)
+				{
+					plan.setBoundary(BoundaryMask::make(*boundary, size, seed));
+				}
+				plan.setPlacementCheck(&check);
+				//the constraints only look at the rooms, their spawns and the graph
+				plan.setLayoutOnly(true);
+				const GenerationStatus status = plan.generate(GenerationBudget(), nullptr, cancel).status;
+				if (status == GenerationStatus::Cancelled)
+				{
+					return;
+				}
+				tried++;
+				if (status == GenerationStatus::Rejected)
+				{
+					abandoned++;
+				}
+				matched = status != GenerationStatus::Rejected && holds(plan);
+			}
+			arena.reset();
+
+			unless(matched)
+			{
+				continue;
+			}
+			std::lock_guard guard(lock);
+			found.insert(std::ranges::upper_bound(found, offset), offset);
+			if (static_cast<int>(found.size()) >= matches)
+			{
+				limit.store(std::min(limit.load(), found[matches - 1] + 1));
+			}
+		}
+	});
+
+	result.tried = tried.load();
+	result.abandoned = abandoned.load();
+	result.cancelled = cancel && cancel->load();
+	for (int i = 0; i < static_cast<int>(found.size()) && i < matches; i++)
+	{
+		result.seeds.push_back(first + static_cast<unsigned int>(found[i]));
+	}
+	return result;
+}
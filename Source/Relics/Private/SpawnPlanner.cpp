@@ -0,0 +1,171 @@
+#include "SpawnPlanner.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "RoomStamps.h"
+
+namespace
+{
+	//the rarest kinds go first, so the enemies fill in around them
+	constexpr SpawnKind PLACEMENT_ORDER[SPAWN_KIND_COUNT] = {SpawnKind::Exit, SpawnKind::Chest, SpawnKind::Enemy};
+}
+
+SpawnSettings SpawnSettings::defaults()
+{
+	SpawnSettings settings;
+	settings.budgets[static_cast<size_t>(SpawnKind::Enemy)] = {1.f, 30, 1, 3, 0, 2.f};
+	settings.budgets[static_cast<size_t>(SpawnKind::Chest)] = {1.f, 0, 1, 1, 0, 2.f};
+	settings.budgets[static_cast<size_t>(SpawnKind::Exit)] = {0.18f, 0, 1, 1, 0, 3.f};
+	return settings;
+}
+
+SpawnPlanner::SpawnPlanner(const int size, const SpawnSettings& settings)
+	: settings(settings), planned{}
+{
+	//no two entries that have to be kept apart are further than a bucket, so a cell only looks at its 3 x 3
+	bucketSize = std::max(1.f, settings.doorClearance);
+	for (const auto& budget : settings.budgets)
+	{
+		bucketSize = std::max(bucketSize, budget.spacing);
+	}
+	buckets = std::max(1, static_cast<int>(std::ceil(static_cast<float>(size) / bucketSize)));
+}
+
+int SpawnPlanner::getBucket(const float r, const float c) const
+{
+	const int br = std::clamp(static_cast<int>(r / bucketSize), 0, buckets - 1);
+	const int bc = std::clamp(static_cast<int>(c / bucketSize), 0, buckets - 1);
+	return br * buckets + bc;
+}
+
+void SpawnPlanner::insert(const float r, const float c, const float radius, const bool door)
+{
+	const int bucket = getBucket(r, c);
+	links.push_back(heads[bucket]);
+	heads[bucket] = static_cast<int>(rows.size());
+	rows.push_back(r);
+	cols.push_back(c);
+	radii.push_back(radius);
+	doors.push_back(door);
+}
+
+bool SpawnPlanner::isClear(const float r, const float c, const float spacing) const
+{
+	const int br = std::clamp(static_cast<int>(r / bucketSize), 0, buckets - 1);
+	const int bc = std::clamp(static_cast<int>(c / bucketSize), 0, buckets - 1);
+	for (int i = std::max(0, br - 1); i <= std::min(buckets - 1, br + 1); i++)
+	{
+		for (int j = std::max(0, bc - 1); j <= std::min(buckets - 1, bc + 1); j++)
+		{
+			for (int entry = heads[i * buckets + j]; entry >= 0; entry = links[entry])
+			{
+				//a door only asks for its clearance, two spawns for the larger spacing of the pair
+				const float distance = doors[entry] ? radii[entry] : std::max(radii[entry], spacing);
+				const float dr = rows[entry] - r;
+				const float dc = cols[entry] - c;
+				if (dr * dr + dc * dc < distance * distance)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void SpawnPlanner::gatherFloor(const RoomImpl& room)
+{
+	candidates.clear();
+	const int height = static_cast<int>(room.getHeight());
+	const int width = static_cast<int>(room.getWidth());
+	unless(RoomStamp::fits(height, width))
+	{
+		//too big for a stamp, everything inside the bounding walls will do
+		for (int r = 1; r + 1 < height; r++)
+		{
+			for (int c = 1; c + 1 < width; c++)
+			{
+				candidates.push_back(r * width + c);
+			}
+		}
+		return;
+	}
+	const RoomStamp stamp = room.getStamp();
+	for (int r = 0; r < height; r++)
+	{
+		for (uint64_t rest = stamp.floor[r]; rest; rest &= rest - 1)
+		{
+			candidates.push_back(r * width + std::countr_zero(rest));
+		}
+	}
+}
+
+int SpawnPlanner::countFor(const SpawnKind kind, RandomGenerator& rg) const
+{
+	const SpawnBudget& budget = settings.budgets[static_cast<size_t>(kind)];
+	if (budget.chance < 1.f && static_cast<float>(rg.getRandom(0, 999)) >= budget.chance * 1000.f)
+	{
+		return 0;
+	}
+	int count = budget.cellsPerSpawn > 0 ? static_cast<int>(candidates.size()) / budget.cellsPerSpawn : budget.minPerRoom;
+	count = std::clamp(count, budget.minPerRoom, std::max(budget.minPerRoom, budget.maxPerRoom));
+	if (budget.maxPerFloor > 0)
+	{
+		count = std::min(count, budget.maxPerFloor - planned[static_cast<size_t>(kind)]);
+	}
+	return std::max(0, count);
+}
+
+void SpawnPlanner::plan(const RoomList& rooms, RandomGenerator& rg, std::vector<PlannedSpawn>& out)
+{
+	heads.assign(static_cast<size_t>(buckets) * buckets, -1);
+	links.clear();
+	rows.clear();
+	cols.clear();
+	radii.clear();
+	doors.clear();
+	planned.fill(0);
+
+	for (int index = 0; index < static_cast<int>(rooms.size()); index++)
+	{
+		const RoomImpl& room = rooms[index];
+		if (room.getDoors().empty())
+		{
+			continue;
+		}
+		const auto row = static_cast<float>(room.getRow());
+		const auto col = static_cast<float>(room.getCol());
+		const int width = static_cast<int>(room.getWidth());
+		for (const auto& [r, c] : room.getDoors())
+		{
+			insert(row + static_cast<float>(r), col + static_cast<float>(c), settings.doorClearance, true);
+		}
+		gatherFloor(room);
+
+		for (const SpawnKind kind : PLACEMENT_ORDER)
+		{
+			const float spacing = settings.budgets[static_cast<size_t>(kind)].spacing;
+			int wanted = countFor(kind, rg);
+			//a Fisher-Yates shuffle drawn one cell at a time, stopped as soon as enough have been taken
+			const int count = static_cast<int>(candidates.size());
+			for (int i = 0; i < count && wanted > 0; i++)
+			{
+				std::swap(candidates[i], candidates[rg.getRandom(i, count - 1)]);
+				const int r = candidates[i] / width;
+				const int c = candidates[i] % width;
+				const float fr = row + static_cast<float>(r);
+				const float fc = col + static_cast<float>(c);
+				unless(isClear(fr, fc, spacing))
+				{
+					continue;
+				}
+				insert(fr, fc, spacing, false);
+				out.push_back({kind, index, static_cast<int>(room.getRow()) + r, static_cast<int>(room.getCol()) + c});
+				planned[static_cast<size_t>(kind)]++;
+				wanted--;
+			}
+		}
+	}
+}
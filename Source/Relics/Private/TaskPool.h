@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//work stealing pool: every worker owns a deque, pops its own front and steals from the back of the others
+//the thread that calls parallelFor works on the batch too, so nested calls from inside a task cannot deadlock
+class TaskPool
+{
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepLock;
+    std::condition_variable sleep;
+    std::atomic<int> queued;
+    bool stopping;
+
+    static size_t& home()
+    {
+        thread_local size_t index = 0;
+        return index;
+    }
+
+    bool pop(const size_t first, std::function<void()>& task)
+    {
+        for (size_t k = 0; k < queues.size(); k++)
+        {
+            Queue& queue = *queues[(first + k) % queues.size()];
+            std::lock_guard guard(queue.lock);
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+            if (k == 0)
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            queued--;
+            return true;
+        }
+        return false;
+    }
+
+    void work(const size_t index)
+    {
+        home() = index;
+        std::function<void()> task;
+        while (true)
+        {
+            if (pop(index, task))
+            {
+                task();
+                continue;
+            }
+            std::unique_lock lock(sleepLock);
+            sleep.wait(lock, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() <= 0)
+            {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit TaskPool(const unsigned int threads = std::max(1u, std::thread::hardware_concurrency()))
+        : queued(0), stopping(false)
+    {
+        //queue 0 belongs to outside callers, workers own 1..threads-1
+        for (unsigned int i = 0; i < std::max(1u, threads); i++)
+        {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned int i = 1; i < queues.size(); i++)
+        {
+            workers.emplace_back(&TaskPool::work, this, i);
+        }
+    }
+
+    ~TaskPool()
+    {
+        {
+            std::lock_guard guard(sleepLock);
+            stopping = true;
+        }
+        sleep.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    static TaskPool& shared()
+    {
+        static TaskPool pool;
+        return pool;
+    }
+
+    [[nodiscard]] unsigned int getThreadCount() const
+    {
+        return static_cast<unsigned int>(queues.size());
+    }
+
+    //runs body(0..count-1) across the pool and returns once every index has finished
+    void parallelFor(const int count, const std::function<void(int)>& body)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+        if (workers.empty() || count == 1)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                body(i);
+            }
+            return;
+        }
+
+        std::atomic<int> remaining(count);
+        queued += count;
+        for (int i = 0; i < count; i++)
+        {
+            Queue& queue = *queues[i % queues.size()];
+            std::lock_guard guard(queue.lock);
+            queue.tasks.emplace_back([&body, &remaining, i]
+            {
+                body(i);
+                remaining--;
+            });
+        }
+        {
+            std::lock_guard guard(sleepLock);
+        }
+        sleep.notify_all();
+
+        std::function<void()> task;
+        while (remaining.load() > 0)
+        {
+            if (pop(home(), task))
+            {
+                task();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
@@ -1,22 +1,190 @@
 ﻿#pragma once
     #include <iostream>
-#include <set>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Utils.h"
 
+//one bit per cell, 64 cells of a row to a word, so whole spans are set and tested a word at a time
+//the grid sits inside a band of GUARD rows above and below and a word of columns either side, all set to what
+//off-grid cells read as, so scans compiled for a known size and gap can run over the edge without checking it
+class BitGrid
+{
+public:
+    static constexpr int GUARD = 8;
+
+    //words a row of cols cells takes, its band included
+    static constexpr int wordsFor(const int cols)
+    {
+        return (cols + GUARD + 63) / 64 + 1;
+    }
+
+private:
+    int rows;
+    int cols;
+    int words;
+    std::pmr::vector<uint64_t> bits;
+
+    [[nodiscard]] size_t index(const int r, const int word) const
+    {
+        return static_cast<size_t>(r + GUARD) * words + word + 1;
+    }
+
+public:
+    BitGrid(const int rows, const int cols, const bool band,
+            std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : rows(rows), cols(cols), words(wordsFor(cols)),
+          bits(static_cast<size_t>(rows + 2 * GUARD) * wordsFor(cols), band ? ~uint64_t(0) : 0, memory)
+    {
+        for (int r = 0; r < rows; r++)
+        {
+            setSpan(r, 0, cols, false);
+        }
+    }
+
+    BitGrid()
+        : rows(0), cols(0), words(0)
+    {
+    }
+
+    //the word holding columns 0..63 of row 0, rows are wordsFor(cols) apart and the band is reachable from it
+    [[nodiscard]] const uint64_t* getOrigin() const
+    {
+        return bits.data() + index(0, 0);
+    }
+
+    [[nodiscard]] bool test(const int r, const int c) const
+    {
+        return bits[index(r, c / 64)] >> (c % 64) & 1;
+    }
+
+    void set(const int r, const int c, const bool value)
+    {
+        const uint64_t bit = uint64_t(1) << (c % 64);
+        uint64_t& word = bits[index(r, c / 64)];
+        word = value ? word | bit : word & ~bit;
+    }
+
+    //sets or clears the cells of row r under mask, whose bit 0 is column c, bits past the last column are dropped
+    void setRow(const int r, const int c, uint64_t mask, const bool value)
+    {
+        if (c + 64 > cols)
+        {
+            mask &= (uint64_t(1) << (cols - c)) - 1;
+        }
+        const int word = c / 64;
+        const int shift = c % 64;
+        uint64_t& low = bits[index(r, word)];
+        low = value ? low | mask << shift : low & ~(mask << shift);
+        if (shift && word + 1 < words)
+        {
+            uint64_t& high = bits[index(r, word + 1)];
+            high = value ? high | mask >> (64 - shift) : high & ~(mask >> (64 - shift));
+        }
+    }
+
+    //sets or clears columns from..to-1 of row r, whole words at a time in between the ends
+    void setSpan(const int r, const int from, const int to, const bool value)
+    {
+        if (from >= to)
+        {
+            return;
+        }
+        const int first = from / 64;
+        const int last = (to - 1) / 64;
+        const uint64_t head = ~uint64_t(0) << (from % 64);
+        const uint64_t tail = ~uint64_t(0) >> (63 - (to - 1) % 64);
+        uint64_t* row = bits.data() + index(r, 0);
+        const auto apply = [value](uint64_t& word, const uint64_t mask)
+        {
+            word = value ? word | mask : word & ~mask;
+        };
+        if (first == last)
+        {
+            apply(row[first], head & tail);
+            return;
+        }
+        apply(row[first], head);
+        std::fill(row + first + 1, row + last, value ? ~uint64_t(0) : 0);
+        apply(row[last], tail);
+    }
+
+    //whether any cell in rows r0..r1 and columns c0..c1 is set, both inclusive and already clipped to the grid
+    [[nodiscard]] bool any(const int r0, const int c0, const int r1, const int c1) const
+    {
+        const int first = c0 / 64;
+        const int last = c1 / 64;
+        const uint64_t head = ~uint64_t(0) << (c0 % 64);
+        const uint64_t tail = ~uint64_t(0) >> (63 - c1 % 64);
+        for (int r = r0; r <= r1; r++)
+        {
+            const uint64_t* row = bits.data() + index(r, 0);
+            if (first == last)
+            {
+                if (row[first] & head & tail)
+                {
+                    return true;
+                }
+                continue;
+            }
+            if (row[first] & head || row[last] & tail)
+            {
+                return true;
+            }
+            for (int w = first + 1; w < last; w++)
+            {
+                if (row[w])
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    //set cells of the grid itself, the band is not counted
+    [[nodiscard]] int count() const
+    {
+        int total = 0;
+        for (int r = 0; r < rows; r++)
+        {
+            for (int c = 0; c < cols; c += 64)
+            {
+                const uint64_t word = bits[index(r, c / 64)];
+                total += std::popcount(c + 64 > cols ? word & ((uint64_t(1) << (cols - c)) - 1) : word);
+            }
+        }
+        return total;
+    }
+};
+
 class TwoDArray
 {
     const int row;
     const int col;
     int overflow;
-    std::string data;
+    std::pmr::string data;
     const char empty;
-    const std::set<char> nonBlocking = {'X'};
+    //mirrors of data for the placement scans, cells something was drawn on and cells of the mask
+    BitGrid occupied;
+    BitGrid masked;
+    static constexpr std::string_view nonBlocking = "X";
+
+    static bool isNonBlocking(const char ch)
+    {
+        return nonBlocking.find(ch) != std::string_view::npos;
+    }
 
 public:
-    TwoDArray(const int row, const int col, const char empty = '-') :
-        row(row), col(col), overflow(10), data(row * (col + 1), empty), empty(empty)
+    TwoDArray(const int row, const int col, const char empty = '-',
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        row(row), col(col), overflow(10), data(row * (col + 1), empty, memory), empty(empty),
+        occupied(row, col, false, memory), masked(row, col, true, memory)
     {
         const int max = static_cast<int>(data.size());
         for (int i = col; i < max; i += col + 1)
@@ -36,10 +204,6 @@ public:
         {
             return data[(row - r - 1) * (col + 1) + c];
         }
-        if (defaultValue == '\0')
-        {
-            std::cout << "attempted to get out of bounds" << std::endl;
-        }
         return defaultValue;
     }
 
@@ -52,14 +216,65 @@ public:
         if (r >= 0 && r < row && c >= 0 && c < col)
         {
             data[(row - r - 1) * (col + 1) + c] = ch;
+            occupied.set(r, c, ch != empty && !isNonBlocking(ch));
+            masked.set(r, c, isNonBlocking(ch));
         }
         else
         {
-            std::cout << "attempted to set out of bounds" << std::endl;
             overflow--;
         }
     }
 
+    //cells something blocking was drawn on, and cells of the mask, both with a band reading like off-grid cells
+    [[nodiscard]] const BitGrid& getOccupied() const
+    {
+        return occupied;
+    }
+
+    [[nodiscard]] const BitGrid& getMasked() const
+    {
+        return masked;
+    }
+
+    //writes ch on every cell of row r under cells, whose bit 0 is column c, and hole where holes is set as well
+    void drawRow(const int r, const int c, uint64_t cells, const char ch, uint64_t holes, const char hole)
+    {
+        if (r < 0 || r >= row || c < 0 || c >= col)
+        {
+            return;
+        }
+        if (c + 64 > col)
+        {
+            cells &= (uint64_t(1) << (col - c)) - 1;
+        }
+        holes &= cells;
+        char* line = data.data() + (row - r - 1) * (col + 1) + c;
+        for (uint64_t rest = cells; rest; rest &= rest - 1)
+        {
+            const int bit = std::countr_zero(rest);
+            line[bit] = holes >> bit & 1 ? hole : ch;
+        }
+        const uint64_t solid = cells & ~holes;
+        occupied.setRow(r, c, solid, ch != empty && !isNonBlocking(ch));
+        masked.setRow(r, c, solid, isNonBlocking(ch));
+        occupied.setRow(r, c, holes, hole != empty && !isNonBlocking(hole));
+        masked.setRow(r, c, holes, isNonBlocking(hole));
+    }
+
+    //writes ch on columns from..to-1 of row r, clipped to the grid
+    void fillRow(const int r, int from, int to, const char ch)
+    {
+        from = std::max(from, 0);
+        to = std::min(to, col);
+        if (r < 0 || r >= row || from >= to)
+        {
+            return;
+        }
+        std::fill_n(data.data() + (row - r - 1) * (col + 1) + from, to - from, ch);
+        occupied.setSpan(r, from, to, ch != empty && !isNonBlocking(ch));
+        masked.setSpan(r, from, to, isNonBlocking(ch));
+    }
+
     [[nodiscard]] bool isEmpty(const int r, const int c, const int s, const int gap) const
     {
         if (s == 0)
@@ -78,11 +293,11 @@ public:
             {
                 continue;
             }
-            if (nonBlocking.contains(a) && (i < 0 || i > s))
+            if (isNonBlocking(a) && (i < 0 || i > s))
             {
                 continue;
             }
-            if (nonBlocking.contains(b) && (i < 0 || i > s))
+            if (isNonBlocking(b) && (i < 0 || i > s))
             {
                 continue;
             }
@@ -91,7 +306,29 @@ public:
         return true;
     }
 
-    [[nodiscard]] bool isEmpty(const int r, const int c, const int w, const int h, const int gap)
+    [[nodiscard]] bool isEmpty(const int r, const int c, const int w, const int h, const int gap) const
+    {
+        //nothing drawn anywhere within the gap, and no mask or grid edge inside the footprint
+        //the footprint reaches one cell past w and h, as far as the gap lets the scan go
+        const int innerRow = r + h - (gap > 0 ? 0 : 1);
+        const int innerCol = c + w - (gap > 0 ? 0 : 1);
+        if (r < 0 || c < 0 || innerRow >= row || innerCol >= col)
+        {
+            return slowIsEmpty(r, c, w, h, gap);
+        }
+        if (innerRow >= r && innerCol >= c && masked.any(r, c, innerRow, innerCol))
+        {
+            return false;
+        }
+        const int r0 = std::max(r - gap, 0);
+        const int c0 = std::max(c - gap, 0);
+        const int r1 = std::min(r + h + gap, row) - 1;
+        const int c1 = std::min(c + w + gap, col) - 1;
+        return r0 > r1 || c0 > c1 || !occupied.any(r0, c0, r1, c1);
+    }
+
+    //the footprint-hanging-off-the-grid case, cell by cell the way isEmpty used to do it
+    [[nodiscard]] bool slowIsEmpty(const int r, const int c, const int w, const int h, const int gap) const
     {
         for (int i = r - gap; i < r + h + gap; i++)
         {
@@ -102,7 +339,7 @@ public:
                 {
                     continue;
                 }
-                if (nonBlocking.contains(a) && ((i < r || i > r + h) || (j < c || j > c + w)))
+                if (isNonBlocking(a) && ((i < r || i > r + h) || (j < c || j > c + w)))
                 {
                     continue;
                 }
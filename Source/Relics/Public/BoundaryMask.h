@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+//columns from..to-1 of a row
+using MaskSpan = std::pair<int, int>;
+
+enum class BoundaryShape : unsigned char
+{
+    Circle,
+    Island,
+    Cave
+};
+
+//the outline of a floor, everything outside it is masked off before the first room is placed
+//a mask hands out the open spans of a row at a time, so the grid is filled a run at a time instead of a cell at a time
+class BoundaryMask
+{
+public:
+    virtual ~BoundaryMask() = default;
+    //appends the open spans of row r of a size x size grid, left to right and clipped to the grid
+    //anything a mask needs for the row comes from the memory resource of spans
+    virtual void getSpans(int r, int size, std::pmr::vector<MaskSpan>& spans) const = 0;
+
+    //the seeded shapes a floor can be given by name, the same seed and size always give the same outline
+    static std::unique_ptr<BoundaryMask> make(BoundaryShape shape, int size, unsigned int seed);
+};
+
+//the disc GeneratorImpl has always cut out, cell for cell
+class CircleMask : public BoundaryMask
+{
+    [[nodiscard]] static bool isOutside(int r, int c, int size);
+
+public:
+    void getSpans(int r, int size, std::pmr::vector<MaskSpan>& spans) const override;
+};
+
+//a closed polygon in cells, a cell is open when its centre is inside by the even-odd rule
+class PolygonMask : public BoundaryMask
+{
+    //(row, column) corners
+    std::vector<std::pair<float, float>> corners;
+
+public:
+    explicit PolygonMask(std::vector<std::pair<float, float>> corners);
+    void getSpans(int r, int size, std::pmr::vector<MaskSpan>& spans) const override;
+};
+
+//a signed distance in cells, negative inside, sampled at cell centres
+//lipschitz bounds how fast the distance can change per cell, a row skips ahead |distance| / lipschitz cells
+//at a time, so a true distance field with 1 samples only a few cells per row
+class SdfMask : public BoundaryMask
+{
+    std::function<float(float r, float c)> distance;
+    float lipschitz;
+
+public:
+    SdfMask(std::function<float(float r, float c)> distance, float lipschitz = 1.f);
+    void getSpans(int r, int size, std::pmr::vector<MaskSpan>& spans) const override;
+};
+
+//a grayscale image stretched over the grid, pixels at or above threshold are open
+class ImageMask : public BoundaryMask
+{
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+    uint8_t threshold;
+
+public:
+    //pixels row by row, the first row lands on grid row 0
+    ImageMask(int width, int height, std::vector<uint8_t> pixels, uint8_t threshold = 128);
+    void getSpans(int r, int size, std::pmr::vector<MaskSpan>& spans) const override;
+};
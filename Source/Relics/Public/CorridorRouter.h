@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "RoomGraph.h"
+#include "TwoDArray.h"
+
+//a routed path between two rooms, from a door of room a to the linked door of room b with both doors included
+struct Corridor
+{
+    int link;
+    CellList cells;
+};
+
+using CorridorList = std::pmr::vector<Corridor>;
+
+//routes corridors through the gap band with A*, reusing its buffers across every corridor of a batch
+//cells another corridor already uses are cheaper, so later corridors merge into earlier ones instead of running beside them
+class CorridorRouter
+{
+    static constexpr uint8_t BLOCKED = 0;
+    static constexpr uint8_t SHARED = 1;
+    static constexpr uint8_t FREE = 2;
+
+    struct Node
+    {
+        uint32_t f;
+        int cell;
+    };
+
+    int size;
+    int maxExpansions;
+    std::vector<uint8_t> cost;
+    std::vector<uint32_t> g;
+    std::vector<int> parent;
+    //a cell's g and parent are only valid while its stamp matches the current search, so nothing is cleared between searches
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> closed;
+    uint32_t stamp;
+    std::vector<Node> open;
+    std::vector<int> sources;
+
+    bool search(int target, CellList& path);
+
+public:
+    explicit CorridorRouter(int maxExpansions = 1 << 16);
+    //mask and room cells are walls, everything else in the grid is open
+    void reset(const TwoDArray& grid, const RoomIdLayer& roomIds);
+    //routes one corridor per link from whichever door of room a reaches link's door in room b cheapest
+    //returns how many links could not be routed
+    int routeAll(const RoomGraph& graph, CorridorList& out);
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "DungeonCollisionComponent.generated.h"
+
+class UBodySetup;
+
+//one physics body made of many boxes, so the merged walls of a floor cost the broadphase a single entry
+//draws nothing, the instanced cubes stay the visible walls
+UCLASS(ClassGroup = (Collision))
+class RELICS_API UDungeonCollisionComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TObjectPtr<UBodySetup> bodySetup;
+
+	//in component space
+	FBox localBounds;
+
+public:
+	UDungeonCollisionComponent();
+
+	//replaces the body's shapes, boxes are in component space
+	void setBoxes(const TArray<FBox>& boxes);
+	int32 getBoxCount() const;
+
+	virtual UBodySetup* GetBodySetup() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+};
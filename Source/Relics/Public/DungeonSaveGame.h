@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Generator.h"
+#include "GameFramework/SaveGame.h"
+#include "DungeonSaveGame.generated.h"
+
+//a floor in progress, saved as what regenerates it and one bit per spawn slot rather than as its actors
+UCLASS()
+class RELICS_API UDungeonSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, Category = "Generator stuff")
+	FDungeonDescriptor dungeon;
+
+	//FloorDelta's bytes, see AGenerator::consumeSlot
+	UPROPERTY(VisibleAnywhere, Category = "Generator stuff")
+	TArray<uint8> delta;
+};
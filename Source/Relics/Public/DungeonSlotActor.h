@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "DungeonSlotActor.generated.h"
+
+UINTERFACE(MinimalAPI, Blueprintable)
+class UDungeonSlotActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+//lets chests and exits show that they were used before the floor was saved
+class RELICS_API IDungeonSlotActor
+{
+	GENERATED_BODY()
+
+public:
+	//called right after spawning into a slot the loaded delta marks as used up
+	UFUNCTION(BlueprintImplementableEvent, Category = "Generator stuff")
+	void restoreConsumed();
+};
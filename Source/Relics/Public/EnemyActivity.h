@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+
+#include "CoreMinimal.h"
+#include "RoomGraph.h"
+
+class AActor;
+class UActorComponent;
+
+//puts enemies to sleep while their room is more than maxHops doors away from every player's room
+//a sleeping enemy does not tick, animate, run its behaviour or perceive, and wakes once a player comes closer
+class RELICS_API EnemyActivity
+{
+	struct Sleeper
+	{
+		TWeakObjectPtr<AActor> actor;
+		int room;
+		bool dormant;
+		//only what was running when the enemy fell asleep is restarted
+		TArray<TWeakObjectPtr<AActor>> pausedActors;
+		TArray<TWeakObjectPtr<UActorComponent>> pausedComponents;
+		TArray<TWeakObjectPtr<UActorComponent>> deactivated;
+	};
+
+	const RoomGraph& graph;
+	int maxHops;
+	//one per player, in the order they were last given
+	std::vector<int> playerRooms;
+	int dormantCount;
+	std::vector<int> hops;
+	std::vector<Sleeper> enemies;
+
+	int roomAt(const FVector& location, int fallback) const;
+	static void pauseActor(AActor* actor, Sleeper& sleeper);
+	void sleep(Sleeper& sleeper);
+	void wake(Sleeper& sleeper);
+
+public:
+	EnemyActivity(const RoomGraph& graph, int maxHops);
+	~EnemyActivity();
+	void add(AActor* enemy);
+	//with leaving given, far enemies are handed back and forgotten instead of being put to sleep
+	void update(const TArray<FVector>& players, TArray<AActor*>* leaving = nullptr);
+	void wakeAll();
+	[[nodiscard]] int getDormantCount() const;
+	//whether a room is within maxHops of any player's room as of the last update
+	[[nodiscard]] bool isNear(int room) const;
+};
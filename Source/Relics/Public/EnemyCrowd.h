@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "RoomGraph.h"
+#include "Relics/Utils/Utils.h"
+
+//enemies far from the player kept as plain data instead of actors
+//each one wanders its own room one grid step at a time and is drawn as an instance, a structure of arrays
+//keeps step() a straight walk over memory so a floor can hold many more of them than it could actors
+class EnemyCrowd
+{
+    const RoomGraph& graph;
+    RandomGenerator rg;
+    float speed;
+
+    std::vector<float> rows;
+    std::vector<float> cols;
+    std::vector<float> yaws;
+    std::vector<int> targetRows;
+    std::vector<int> targetCols;
+    std::vector<float> waits;
+    std::vector<int> rooms;
+    std::vector<int> slots;
+    //whatever the actor was carrying when it was demoted, handed back untouched when it is promoted again
+    std::vector<std::vector<uint8_t>> states;
+
+    //a cell the proxy can stand on, inside the room and clear of its walls
+    [[nodiscard]] bool isFloor(int room, int r, int c) const;
+    //moves (r, c) to the closest floor cell of the room, false when the room has none
+    [[nodiscard]] bool nearestFloor(int room, int& r, int& c) const;
+    void pickTarget(int index);
+
+public:
+    static constexpr float MAX_WAIT = 3.f;
+
+    //speed in cells per second
+    EnemyCrowd(const RoomGraph& graph, unsigned int seed, float speed = 1.5f);
+    //r and c in cells, returns the proxy's index until the next remove
+    int add(int room, int slot, float r, float c, float yaw, std::vector<uint8_t> state = {});
+    //the last proxy takes the removed one's index
+    void remove(int index);
+    void clear();
+    void step(float seconds);
+    [[nodiscard]] int getCount() const;
+    [[nodiscard]] int getRoom(int index) const;
+    [[nodiscard]] int getSlot(int index) const;
+    [[nodiscard]] float getRow(int index) const;
+    [[nodiscard]] float getCol(int index) const;
+    //grid angle in degrees, the way the proxy last stepped
+    [[nodiscard]] float getYaw(int index) const;
+    [[nodiscard]] const std::vector<uint8_t>& getState(int index) const;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "WallGrid.h"
+
+//columns from..to-1 of row r
+struct CellSpan
+{
+    int r;
+    int from;
+    int to;
+};
+
+//what can be seen from one cell of the floor, by recursive shadowcasting over the wall bits, and what ever was
+//visible and explored are bitsets the size of the floor, but an update only clears, casts and compares the
+//words of the square around the old and the new origin, and only when the origin moved to another cell
+class FieldOfView
+{
+    const WallGrid& walls;
+    int radius;
+    int size;
+    int words;
+    std::vector<uint64_t> visible;
+    std::vector<uint64_t> explored;
+    //the last window's visible words, to tell what changed once the new one is cast
+    std::vector<uint64_t> previous;
+    int originR;
+    int originC;
+    //rows firstRow..lastRow and words firstWord..lastWord of the square around the origin
+    int firstRow;
+    int lastRow;
+    int firstWord;
+    int lastWord;
+    std::vector<CellSpan> changed;
+    std::vector<CellSpan> discovered;
+
+    void castLight(int row, float start, float end, int xx, int xy, int yx, int yy);
+    void markVisible(int r, int c);
+    //the runs of set bits of word w of row r, joined onto the last span when they carry on from it
+    static void appendRuns(int r, int w, uint64_t bits, std::vector<CellSpan>& out);
+
+public:
+    FieldOfView(const WallGrid& walls, int radius);
+    //recasts from (r, c), false without touching anything when the origin is still on the same cell
+    bool update(int r, int c);
+    //forgets what was seen and explored, the next update reports everything it sees
+    void reset();
+    //cells that came into or went out of view on the last update that recast
+    [[nodiscard]] const std::vector<CellSpan>& getChanged() const;
+    //cells seen for the first time on the last update that recast
+    [[nodiscard]] const std::vector<CellSpan>& getDiscovered() const;
+    [[nodiscard]] bool isVisible(int r, int c) const;
+    [[nodiscard]] bool isExplored(int r, int c) const;
+    [[nodiscard]] int getRadius() const;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "FloorPlan.h"
+
+//what has changed on a floor since it was generated, one bit per spawn slot
+//a set bit means the slot's actor has been used up: the enemy killed, the chest opened or the exit taken
+class FloorDelta
+{
+    std::vector<int> firstSlot;
+    std::vector<uint8_t> bits;
+
+public:
+    FloorDelta();
+    explicit FloorDelta(const FloorPlan& plan);
+    [[nodiscard]] int getRoomCount() const;
+    [[nodiscard]] int getSlotCount() const;
+    [[nodiscard]] int getSlotCount(int room) const;
+    //the slot's position in the bit string, -1 when the floor has no such slot
+    [[nodiscard]] int toIndex(int room, int slot) const;
+    void set(int room, int slot, bool value = true);
+    [[nodiscard]] bool test(int room, int slot) const;
+    [[nodiscard]] bool any() const;
+    void clear();
+    [[nodiscard]] const std::vector<uint8_t>& getBytes() const;
+    //rejects bytes made for a floor with a different number of slots
+    bool setBytes(const uint8_t* data, size_t count);
+};
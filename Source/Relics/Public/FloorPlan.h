@@ -0,0 +1,138 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "GeneratorImpl.h"
+#include "RoomGraph.h"
+#include "RoomInterior.h"
+#include "RoomPaths.h"
+#include "SpawnPlanner.h"
+#include "WallGrid.h"
+
+//one instance of the wall cube, in cells, as ARoom::getSegmentTransform takes it
+struct WallSegment
+{
+    float r;
+    float c;
+    float alt;
+    float rScale;
+    float cScale;
+    float zScale;
+};
+
+//x and y are offsets from the room's origin in world units
+struct SpawnPoint
+{
+    SpawnKind kind;
+    float x;
+    float y;
+};
+
+struct RoomPlan
+{
+    RoomImpl room;
+    unsigned int alt;
+    std::vector<WallSegment> segments;
+    std::vector<SpawnPoint> spawns;
+    std::vector<PropInstance> props;
+};
+
+//everything AGenerator needs to put a floor into the world, built without touching the engine
+//so it can be prepared on a worker thread while the current floor is played
+class FloorPlan
+{
+    int size;
+    int room_min;
+    int room_max;
+    int gap;
+    unsigned int seed;
+    bool complete;
+    //where the generator keeps its working set, the finished plan itself always lives on the heap
+    std::pmr::memory_resource* memory;
+    std::shared_ptr<const BoundaryMask> boundary;
+    const PlacementCheck* placementCheck;
+    //stops at the rooms, their spawns and the graph
+    bool layoutOnly;
+    std::vector<RoomPlan> rooms;
+    RoomGraph graph;
+    std::vector<Corridor> corridors;
+    std::vector<WallSegment> corridorSegments;
+    std::vector<WallSegment> colliders;
+    //every room's props in floor cells, one list per kind
+    std::array<std::vector<PropInstance>, PROP_KIND_COUNT> props;
+    //every room's spawns in floor cells, room by room, each room keeps its own copy for its slots
+    std::vector<PlannedSpawn> spawns;
+    WallGrid walls;
+    RoomPaths paths;
+    //kept between calls while a budget leaves the layout unfinished
+    std::unique_ptr<GeneratorImpl> generator;
+    GenerationReport report;
+
+    static constexpr float CORRIDOR_HEIGHT = 0.02f;
+
+    static constexpr unsigned int SPAWN_STREAM = 0x5BD1E995u;
+    static constexpr unsigned int STEP_STREAM = 0x27D4EB2Fu;
+
+    static RoomPlan planRoom(const RoomImpl& room, RandomGenerator& rg);
+    //false once the floor is complete and there is no generator left to carry on
+    bool prepare(GenerationLog* log, const std::atomic<bool>* cancel);
+    //plans the floor from whatever the generator has placed so far
+    GenerationReport planFloor(const std::atomic<bool>* cancel);
+    //plans the rooms alone, their walls without spawns, props, corridors or anything else of the floor
+    void planSteppedRooms();
+    void planSpawns();
+    void planWalls();
+    void planInteriors();
+    void planCorridors();
+    void planColliders();
+    //greedy boxes over a width x width cell mask, origin is the grid coordinate of its first cell
+    static void mergeCells(const std::vector<unsigned char>& cells, int width, int origin, float alt, float zScale,
+                           std::vector<WallSegment>& out);
+
+public:
+    FloorPlan(int size, int room_min, int room_max, int gap, unsigned int seed,
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~FloorPlan();
+    //the outline the floor is cut to, the circle when none is set, set it before the first generate
+    void setBoundary(std::shared_ptr<const BoundaryMask> mask);
+    //handed to the generator, a rejected layout is dropped like a cancelled one, not owned
+    void setPlacementCheck(const PlacementCheck* check);
+    //plans only the rooms, their spawns and the graph, for floors that are scored but never built
+    void setLayoutOnly(bool only);
+    bool generate(GenerationLog* log = nullptr, const std::atomic<bool>* cancel = nullptr);
+    //plans whatever the budget allowed, a partial floor is playable and a later call carries on where it stopped
+    GenerationReport generate(const GenerationBudget& budget, GenerationLog* log = nullptr,
+                              const std::atomic<bool>* cancel = nullptr);
+    //like generate, but nothing is planned until the layout is finished, for spreading one floor over many frames
+    GenerationReport resume(const GenerationBudget& budget, GenerationLog* log = nullptr,
+                            const std::atomic<bool>* cancel = nullptr);
+    //carries the layout on by one step, only the rooms are planned until the step reaches Done and the rest of the
+    //floor with it, a room may show up before its walls do
+    GenerationStep step(GenerationLog* log = nullptr);
+    [[nodiscard]] const GenerationReport& getReport() const;
+    [[nodiscard]] bool isComplete() const;
+    [[nodiscard]] const std::vector<RoomPlan>& getRooms() const;
+    [[nodiscard]] const RoomGraph& getGraph() const;
+    [[nodiscard]] const std::vector<Corridor>& getCorridors() const;
+    //the corridors' floor strips in grid coordinates, overlapping corridors are merged into shared boxes
+    [[nodiscard]] const std::vector<WallSegment>& getCorridorSegments() const;
+    //the rooms' walls, overheads and ceilings merged into as few boxes as their height bands allow, in dungeon cells
+    [[nodiscard]] const std::vector<WallSegment>& getColliders() const;
+    //the props furnishing the rooms in floor cells, a list per kind so each can go into one instanced mesh
+    [[nodiscard]] const std::vector<PropInstance>& getProps(PropKind kind) const;
+    [[nodiscard]] const std::vector<PlannedSpawn>& getSpawns() const;
+    //the rooms' walls without their doors, what sight lines and light are stopped by
+    [[nodiscard]] const WallGrid& getWalls() const;
+    //the doors as portals with the walks between them cached, for path queries across the whole floor
+    [[nodiscard]] const RoomPaths& getPaths() const;
+    [[nodiscard]] size_t getMemoryUsage() const;
+    [[nodiscard]] static size_t estimateMemoryUsage(int size);
+    [[nodiscard]] int getSize() const;
+    [[nodiscard]] int getRoomMin() const;
+    [[nodiscard]] int getRoomMax() const;
+    [[nodiscard]] int getGap() const;
+    [[nodiscard]] unsigned int getSeed() const;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+//a monotonic arena for one generation run at a time
+//reset keeps the block for the next run and grows it once when a run spilled, so repeated runs stop allocating
+//one arena per thread, it is not synchronised
+class GenerationArena final : public std::pmr::memory_resource
+{
+    //where the arena goes when its block is full, counted so a spill shows up
+    class Upstream final : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t count, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t count, size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override;
+    };
+
+    Upstream upstream;
+    std::unique_ptr<std::byte[]> block;
+    size_t blockSize;
+    std::optional<std::pmr::monotonic_buffer_resource> buffer;
+    size_t allocations;
+    size_t used;
+
+    void* do_allocate(size_t count, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t count, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override;
+
+public:
+    explicit GenerationArena(size_t initialBytes = 1 << 20);
+    GenerationArena(const GenerationArena&) = delete;
+    GenerationArena& operator=(const GenerationArena&) = delete;
+
+    //everything allocated since the last reset is gone, containers using the arena must be destroyed first
+    void reset();
+    //allocations served since the last reset
+    [[nodiscard]] size_t getAllocations() const;
+    [[nodiscard]] size_t getUsedBytes() const;
+    //allocations that did not fit the block and went to the global heap since the last reset, 0 in steady state
+    [[nodiscard]] size_t getSpills() const;
+    [[nodiscard]] size_t getCapacity() const;
+};
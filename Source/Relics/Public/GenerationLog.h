@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//every event is one type byte, a varint of nanoseconds since the previous event and a varint payload
+//probes store a zigzag delta of the cell index from the previous probe, so a scan costs ~3 bytes per cell
+enum class GenerationEvent : uint8_t
+{
+    Mask,
+    ProbeFit,
+    ProbeSpace,
+    Place,
+    Reshape,
+    Door,
+    Retry,
+    End,
+    Count
+};
+
+struct GenerationRecord
+{
+    GenerationEvent type;
+    uint64_t nanos;
+    int id;
+    int row;
+    int col;
+    int width;
+    int height;
+    int value;
+};
+
+class GenerationLog
+{
+    std::vector<uint8_t> bytes;
+    std::chrono::steady_clock::time_point last;
+    int size;
+    int lastProbe;
+
+    void writeVarint(uint64_t value);
+    void writeSigned(int64_t value);
+    void writeEvent(GenerationEvent type);
+
+public:
+    static constexpr char MAGIC[4] = {'R', 'G', 'L', '1'};
+
+    GenerationLog();
+    void begin(int size, int room_min, int room_max, int gap, unsigned int seed);
+    void mask();
+    void probe(GenerationEvent type, int r, int c);
+    void place(unsigned int id, int r, int c, int w, int h);
+    void reshape(unsigned int id, unsigned char shape);
+    void door(unsigned int id, int r, int c);
+    void retry(int retries);
+    void end(bool result);
+    [[nodiscard]] const std::vector<uint8_t>& getBytes() const;
+    bool save(const std::string& path) const;
+};
+
+class GenerationLogReader
+{
+    const std::vector<uint8_t>& bytes;
+    size_t pos;
+    int lastProbe;
+
+    bool readVarint(uint64_t& value);
+    bool readSigned(int64_t& value);
+
+public:
+    int size;
+    int room_min;
+    int room_max;
+    int gap;
+    unsigned int seed;
+
+    explicit GenerationLogReader(const std::vector<uint8_t>& bytes);
+    [[nodiscard]] bool valid() const;
+    bool next(GenerationRecord& record);
+};
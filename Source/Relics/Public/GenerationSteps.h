@@ -0,0 +1,140 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory_resource>
+#include <utility>
+
+//where a generation run is parked between resumes
+enum class GenerationStep : unsigned char
+{
+    //nothing has run yet
+    Start,
+    //about to scan for a place for the next room, the only step a budget may stop at
+    Attempt,
+    //a room has its place on the grid but is still a box
+    Placed,
+    Reshaped,
+    //the room has its doors and is drawn into the grid
+    Doors,
+    Done
+};
+
+//a generation run as a coroutine, resumed a step at a time by whoever drives it
+//the frame comes from the owner's memory resource, so a run on an arena stays off the global heap
+class GenerationSteps
+{
+public:
+    struct promise_type
+    {
+        GenerationStep step = GenerationStep::Start;
+
+        //the frame starts HEADER bytes into its block, the resource it came from is kept in front of it for delete
+        static constexpr size_t HEADER = alignof(std::max_align_t);
+
+        template <typename Owner>
+        static void* operator new(const size_t bytes, Owner& owner)
+        {
+            std::pmr::memory_resource* memory = owner.getMemory();
+            auto* block = static_cast<std::byte*>(memory->allocate(bytes + HEADER, alignof(std::max_align_t)));
+            *reinterpret_cast<std::pmr::memory_resource**>(block) = memory;
+            return block + HEADER;
+        }
+
+        static void operator delete(void* pointer, const size_t bytes)
+        {
+            std::byte* block = static_cast<std::byte*>(pointer) - HEADER;
+            (*reinterpret_cast<std::pmr::memory_resource**>(block))->deallocate(block, bytes + HEADER,
+                                                                               alignof(std::max_align_t));
+        }
+
+        GenerationSteps get_return_object()
+        {
+            return GenerationSteps(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always yield_value(const GenerationStep reached) noexcept
+        {
+            step = reached;
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+            step = GenerationStep::Done;
+        }
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit GenerationSteps(const std::coroutine_handle<promise_type> handle)
+        : handle(handle)
+    {
+    }
+
+public:
+    GenerationSteps()
+        : handle(nullptr)
+    {
+    }
+
+    GenerationSteps(GenerationSteps&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    GenerationSteps& operator=(GenerationSteps&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    GenerationSteps(const GenerationSteps&) = delete;
+    GenerationSteps& operator=(const GenerationSteps&) = delete;
+
+    ~GenerationSteps()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    //runs to the next step and returns it, Done from then on
+    GenerationStep next()
+    {
+        if (handle && !handle.done())
+        {
+            handle.resume();
+        }
+        return getStep();
+    }
+
+    [[nodiscard]] GenerationStep getStep() const
+    {
+        return handle ? handle.promise().step : GenerationStep::Start;
+    }
+};
@@ -1,35 +1,307 @@
 ﻿#pragma once
+#include <atomic>
+#include <memory>
 #include <vector>
 
+#include "EnemyActivity.h"
+#include "EnemyCrowd.h"
+#include "FieldOfView.h"
+#include "FloorDelta.h"
+#include "FloorPlan.h"
+#include "LineOfSight.h"
+#include "MinimapRaster.h"
+#include "PortalVisibility.h"
 #include "Room.h"
 #include "RoomImpl.h"
+#include "RoomPaths.h"
 #include "NavMesh/NavMeshBoundsVolume.h"
 
 #include "Generator.generated.h"
 
+//the outline a floor is cut to, see BoundaryMask
+UENUM(BlueprintType)
+enum class EDungeonBoundary : uint8
+{
+	Circle,
+	Island,
+	Cave,
+	//boundaryImage's bright pixels
+	Image
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDungeonNavigationReady);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnFloorDeltaChanged);
+
+//everything a client needs to rebuild the server's floor on its own
+USTRUCT()
+struct FDungeonDescriptor
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 seed = 0;
+
+	UPROPERTY()
+	int32 size = 0;
+
+	UPROPERTY()
+	int32 room_min = 0;
+
+	UPROPERTY()
+	int32 room_max = 0;
+
+	UPROPERTY()
+	int32 gap = 0;
+
+	UPROPERTY()
+	int32 version = 0;
+
+	UPROPERTY()
+	EDungeonBoundary boundary = EDungeonBoundary::Circle;
+
+	//placement attempts of a floor cut short by its budget, 0 when it was generated to the end
+	UPROPERTY()
+	int32 attempts = 0;
+};
+
+//ties an actor the server spawned to the room and spawn slot it came from
+USTRUCT()
+struct FDungeonSlot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 room = 0;
+
+	UPROPERTY()
+	uint16 slot = 0;
+
+	UPROPERTY()
+	TObjectPtr<AActor> actor = nullptr;
+};
+
 UCLASS(Blueprintable)
 class RELICS_API AGenerator : public AActor
 {
 	GENERATED_BODY()
 	std::vector<ARoom*> rooms;
+	TArray<FBox> dirtyNavigationAreas;
+	bool awaitingNavigation;
+
+	//the floor being played and the one being prepared for the next BP_Gate
+	TSharedPtr<FloorPlan> currentFloor;
+	TSharedPtr<FloorPlan> nextFloor;
+	TFuture<TSharedPtr<FloorPlan>> nextFloorTask;
+	EDungeonBoundary nextFloorBoundary;
+	TSharedPtr<std::atomic<bool>> nextFloorCancel;
+	//a floor laid out on the game thread a slice a frame while generationSliceMs is on
+	TSharedPtr<FloorPlan> slicedFloor;
+	//a floor being stepped through by stepGeneration
+	TSharedPtr<FloorPlan> steppedFloor;
+
+	//rooms hidden by portal culling, recomputed when the camera changes cell or turns
+	TUniquePtr<PortalVisibility> portals;
+	std::vector<unsigned char> visibleRooms;
+	std::vector<unsigned char> shownRooms;
+	FIntPoint lastCameraCell;
+	float lastCameraYaw;
+
+	//drawn on a worker when a floor is built, then uploaded a dirty region at a time as it is explored
+	TFuture<TSharedPtr<MinimapRaster>> minimapTask;
+	TSharedPtr<MinimapRaster> minimapRaster;
+	int32 lastMinimapRoom;
+
+	//what the player can see and has seen of the current floor while fogOfWar is on
+	TUniquePtr<FieldOfView> fieldOfView;
+	std::vector<unsigned char> exploredRooms;
+	//how many cells of each room are in sight right now, kept up to date from the cells that changed
+	std::vector<int32> roomCellsInSight;
+	//sight lines asked for during the frame, answered together on the next tick
+	TUniquePtr<LineOfSight> lineOfSight;
+	//long-range paths over the current floor's doors, with the buffers every query reuses
+	TUniquePtr<RoomPathfinder> pathfinder;
+	RoomPath lastPath;
+
+	TUniquePtr<EnemyActivity> activity;
+	//enemies outside every player's vicinity while enemyProxies is on
+	//the server's decides which enemies are actors, a client keeps its own from the same seed only to draw them
+	TUniquePtr<EnemyCrowd> crowd;
+
+	//the merged wall bodies of the current floor, one per chunk
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<class UDungeonCollisionComponent>> wallColliders;
+
+	//one instanced mesh per prop kind furnishing the current floor
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> propInstances;
+
+	//clients only receive the floor's parameters and what has changed on it, never the walls
+	UPROPERTY(ReplicatedUsing = onRepDungeon)
+	FDungeonDescriptor dungeon;
+
+	UPROPERTY(ReplicatedUsing = onRepFloorDelta)
+	TArray<uint8> floorDeltaBytes;
+
+	UPROPERTY(ReplicatedUsing = onRepSlots)
+	TArray<FDungeonSlot> slots;
+
+	FloorDelta floorDelta;
 
 	void clearDungeon();
-	void delayedBuildNavigation();
+	void updatePortalCulling();
+	//where the pawn of every player controller stands, listen server host and clients alike
+	void getPlayerLocations(TArray<FVector>& out) const;
+	void updateEnemyActivity(float seconds);
+	void updateEnemyProxies(const TArray<FVector>& players, float seconds);
+	void demoteEnemy(AActor* actor);
+	void promoteEnemy(int index);
+	void drawEnemyProxies();
+	//a client's crowd holds every enemy slot that is neither used up nor bound to an actor
+	void syncEnemyProxies();
+	void startMinimap(const TSharedPtr<FloorPlan>& plan);
+	void updateMinimap();
+	void uploadMinimap();
+	void updateFieldOfView();
+	void updateLineOfSight();
+	void updateSlicedGeneration();
+	//spawns the rooms of a floor being stepped through on the server alone, nothing else of it exists yet
+	void showSteppedRooms(const FloorPlan& plan);
+	void buildFloor(const TSharedPtr<FloorPlan>& plan, EDungeonBoundary shape, const TArray<uint8>* savedDelta = nullptr);
+	//read on the game thread, the mask is then safe to hand to a worker
+	std::shared_ptr<const BoundaryMask> makeBoundary(EDungeonBoundary shape, int32 floorSize, int32 floorSeed) const;
+	void collectNextFloor();
+	FBox getDungeonBounds() const;
+	void rebuildNavigation();
+	void checkNavigationReady();
+	void bindSlots();
+
+	UFUNCTION()
+	void onRepDungeon();
+
+	UFUNCTION()
+	void onRepFloorDelta();
+
+	UFUNCTION()
+	void onRepSlots();
+
+	UFUNCTION()
+	void onNavigationGenerationFinished(class ANavigationData* navData);
 
 public:
 	void buildBasePlate();
+	void buildCorridors(const FloorPlan& plan);
+	void buildColliders(const FloorPlan& plan);
+	void buildProps(const FloorPlan& plan);
 	void buildNavMesh();
 	void init(int32 tSize, int32 tRoom_min, int32 tRoom_max, int32 tGap, int32 tSeed);
-	ARoom* build(UWorld* world, RandomGenerator& rg, const RoomImpl& room);
+	ARoom* build(UWorld* world, const RoomPlan& room, int32 index);
 
 	AGenerator();
 	~AGenerator();
 
 	virtual void BeginDestroy() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
 	void buildDungeon();
 
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isNavigationReady() const;
+
+	//share of the floor inside the mask covered by rooms, below the usual when a budget cut generation short
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	float getFloorCoverage() const;
+
+	//index of the room at a world position, -1 between rooms or off the floor
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	int32 getRoomAt(FVector location) const;
+
+	//whether the player can see the cell at a world position right now, always true while fogOfWar is off
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isLocationVisible(FVector location) const;
+
+	//whether the player has ever seen the cell at a world position, always true while fogOfWar is off
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isLocationExplored(FVector location) const;
+
+	//whether any cell of the room has been seen, always true while fogOfWar is off
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isRoomExplored(int32 room) const;
+
+	//whether any cell of the room is in sight right now, always true while fogOfWar is off
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isRoomInSight(int32 room) const;
+
+	//queues a sight line against the floor's walls and returns its ticket, or -1 without a floor
+	//every line asked for in a frame is traced together on the generator's next tick, doors and props do not block
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	int32 requestLineOfSight(FVector from, FVector to);
+
+	//false until the ticket's batch has been traced, and again once the batch after it has
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool getLineOfSight(int32 ticket, bool& clear) const;
+
+	//the shortest walk between two world positions through the floor's rooms, doors and corridors, searched over the
+	//doors instead of the nav mesh, false when one end is in a wall or nothing connects them
+	//points follow the cells from the start to the first door, every door after it and the cells from the last door to
+	//the goal, the stretches between doors are short enough to leave to the nav mesh, length is in world units
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool findRoomPath(FVector from, FVector to, TArray<FVector>& points, float& length);
+
+	//starts generating the next floor on a worker thread, a seed of 0 picks a random one
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	void prepareNextFloor(int32 nextSeed);
+
+	//replaces the current floor with the prepared one, generating it in place if nothing was prepared
+	//returns false when the floor had to be generated on the spot
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool commitNextFloor();
+
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	void cancelNextFloor();
+
+	//lays the floor out one step further and shows its rooms, to watch them being placed, reshaped and given doors
+	//the steps are seen on the server alone, the last one builds the whole floor and replicates it like buildDungeon
+	//the first call starts a new floor from seed and the one after the last step starts over
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Generator stuff")
+	void stepGeneration();
+
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isNextFloorReady();
+
+	//marks the slot the actor was spawned into as used up, server only
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	void consumeSlot(AActor* actor);
+
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool findSlot(AActor* actor, int32& room, int32& slot) const;
+
+	UFUNCTION(BlueprintPure, Category = "Generator stuff")
+	bool isSlotConsumed(int32 room, int32 slot) const;
+
+	//the current floor as its parameters and slot delta, small enough to write every checkpoint
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	class UDungeonSaveGame* captureDungeon() const;
+
+	//regenerates the saved floor and spawns it with the delta already applied, server only
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool restoreDungeon(const class UDungeonSaveGame* save);
+
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool saveDungeon(const FString& slotName, int32 userIndex) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Generator stuff")
+	bool loadDungeon(const FString& slotName, int32 userIndex);
+
+	//fires on the server and on clients whenever a slot is consumed
+	UPROPERTY(BlueprintAssignable, Category = "Generator stuff")
+	FOnFloorDeltaChanged onFloorDeltaChanged;
+
+	//fires once the nav tiles touched by the last buildDungeon have been rebuilt
+	UPROPERTY(BlueprintAssignable, Category = "Generator stuff")
+	FOnDungeonNavigationReady onNavigationReady;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff",
 		meta = (ExposeOnSpawn = "true", ClampMin = 16))
 	int32 size;
@@ -50,9 +322,96 @@ public:
 		meta = (ExposeOnSpawn = "true", ClampMin = 0))
 	int32 seed;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ExposeOnSpawn = "true"))
+	EDungeonBoundary boundary;
+
+	//a grayscale texture stretched over the floor for the Image boundary, stored uncompressed (G8 or BGRA8)
+	//so its pixels can be read at runtime, clients need the same texture to rebuild the floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	TObjectPtr<UTexture2D> boundaryImage;
+
+	//writes a binary event log of every generation to Saved/GenerationLogs for Tools/GenLogViewer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool logGeneration;
+
+	//a prepared floor larger than this is thrown away instead of being held until the gate is reached
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 1))
+	int32 nextFloorMemoryCapMB;
+
+	//hides rooms that cannot be seen through the doors of the camera's room
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool portalCulling;
+
+	//rooms further than this many cells from the camera are always hidden while culling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 8))
+	float portalCullDistance;
+
+	//buildDungeon stops placing rooms after this long and plays what it has, 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	float generationBudgetMs;
+
+	//when above 0 buildDungeon lays the floor out on the game thread this long a frame and builds it once finished,
+	//for platforms short on worker threads, generationBudgetMs and logGeneration do not apply then
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	float generationSliceMs;
+
+	//enemies more than dormancyHops doors from every player's room stop ticking, animating and perceiving
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool enemyDormancy;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	int32 dormancyHops;
+
+	//enemies beyond dormancyHops are not actors at all but instanced proxies wandering their room,
+	//turned into actors when any player comes within dormancyHops and back when they are left behind
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool enemyProxies;
+
+	//walls collide as a few large merged boxes instead of one body per wall cube
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool mergedWallCollision;
+
+	//side of the square chunks the merged walls are split into, one body per chunk, 0 for one body per floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	int32 collisionChunkCells;
+
+	//side of the minimap texture in pixels, a cell gets as many whole pixels as fit, 0 turns the minimap off
+	//a dedicated server never draws one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	int32 minimapResolution;
+
+	//cells around the player shown on the minimap, on top of the whole room the player walks into
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 0))
+	int32 minimapRevealRadius;
+
+	//reveals the floor by what the player has seen through the doors rather than by where they have walked,
+	//the minimap then shows exactly the explored cells, a dedicated server sees nothing and skips it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff")
+	bool fogOfWar;
+
+	//in cells, how far the player sees while fogOfWar is on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Generator stuff", meta = (ClampMin = 1, ClampMax = 128))
+	int32 sightRadius;
+
+	//the explored part of the current floor, x along the columns and y along the rows, unexplored texels are clear
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Generator stuff")
+	TObjectPtr<UTexture2D> minimap;
+
 	UPROPERTY(EditAnywhere)
 	UInstancedStaticMeshComponent* blocks;
 
+	//floor strips along the corridors routed between linked doors
+	UPROPERTY(EditAnywhere)
+	UInstancedStaticMeshComponent* corridorBlocks;
+
+	//one instance per enemy proxy, give it the enemy's low detail mesh
+	UPROPERTY(EditAnywhere)
+	UInstancedStaticMeshComponent* enemyProxyMeshes;
+
+	//the room props by PropKind: crate, barrel, pillar, table, chair and rug, kinds left empty are not furnished
+	UPROPERTY(EditAnywhere, Category = "Generator stuff")
+	TArray<TObjectPtr<UStaticMesh>> propMeshes;
+
 	UPROPERTY(EditAnywhere)
 	class UClass* enemy;
 
@@ -1,29 +1,138 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "BoundaryMask.h"
+#include "CorridorRouter.h"
+#include "GenerationLog.h"
+#include "GenerationSteps.h"
+#include "RoomIdLayer.h"
 #include "RoomImpl.h"
+#include "TaskPool.h"
 #include "TwoDArray.h"
 
+//limits on one call to GeneratorImpl::generate, 0 leaves a limit off
+struct GenerationBudget
+{
+    double milliseconds = 0;
+    //placement attempts, each one a scan of the grid for a room that fits
+    int attempts = 0;
+};
+
+enum class GenerationStatus : unsigned char
+{
+    //not finished, the budget ran out first and generate can be called again to carry on
+    Partial,
+    //no space left for another room
+    Complete,
+    //too many rooms in a row did not fit
+    Failed,
+    Cancelled,
+    //a placement check gave up on the layout before it was finished
+    Rejected
+};
+
+struct GenerationReport
+{
+    GenerationStatus status = GenerationStatus::Partial;
+    int rooms = 0;
+    //over every call so far, replaying a partial layout from its seed needs exactly this many
+    int attempts = 0;
+    double milliseconds = 0;
+    //share of the cells inside the mask that rooms cover
+    float coverage = 0;
+};
+
+class GeneratorImpl;
+
+//looked at after every room placed, returning false abandons the layout on the spot
+using PlacementCheck = std::function<bool(const GeneratorImpl& layout)>;
+
 class GeneratorImpl
 {
+public:
+    //bumped whenever the same seed and sizes stop producing the same layout
+    //clients and save games built by another version cannot rebuild the floor from its seed
+    static constexpr int VERSION = 4;
+
+private:
+    static constexpr int PARALLEL_SCAN_CELLS = 64 * 64;
+    static constexpr int BANDS_PER_THREAD = 4;
+
     TwoDArray grid;
     const int size;
     const int room_min;
     const int room_max;
     const int gap;
     RandomGenerator rg;
-    std::vector<RoomImpl> rooms;
+    RoomList rooms;
+    RoomIdLayer roomIds;
+    CorridorList corridors;
+    GenerationLog* log;
+    const std::atomic<bool>* cancel;
+    const PlacementCheck* check;
+    TaskPool& pool;
+    std::pmr::memory_resource* memory;
+    //not owned, the circle when none is set
+    const BoundaryMask* boundary;
+
+    int nextId;
+    int retries;
+    int freeCells;
+    int placedCells;
+    GenerationReport report;
+    //the run itself, parked wherever the last call left it, last so it goes before the state it works on
+    GenerationSteps steps;
 
-    void round();
-    bool placeStuff();
-    bool openSpace() const;
-    bool placeThing(char id);
+    //masks the grid, then places rooms until there is no space left, yielding around every room
+    GenerationSteps run();
+    void finish(GenerationStatus status);
+    void updateReport(std::chrono::steady_clock::time_point start);
+    void applyBoundary();
+    [[nodiscard]] bool useParallelScan(int rows) const;
+    //the placement scans are written once against the tests of GridScans.h, see withScan for which ones they get
+    template <typename Scan>
+    [[nodiscard]] bool openSpace(const Scan& scan) const;
+    template <typename Scan>
+    [[nodiscard]] int findFit(const Scan& scan, int width, int height) const;
+    //calls body with the scan compiled for this size and gap when it is one of the presets, the dynamic one otherwise
+    template <typename Body>
+    decltype(auto) withScan(const Body& body) const;
 
 public:
+    //everything a run allocates comes from memory, pass a GenerationArena to keep repeated runs off the global heap
     GeneratorImpl(int size, int room_min, int room_max, int gap,
-              int seed = RandomGenerator().getRandom());
+              int seed = RandomGenerator().getRandom(),
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     ~GeneratorImpl();
     bool generate();
-    [[nodiscard]] const std::vector<RoomImpl>& getRooms() const;
+    //places rooms until the grid is full or the budget runs out, the layout is valid either way
+    GenerationReport generate(const GenerationBudget& budget);
+    //carries the run on by exactly one step and returns where it stopped, for stepping through a layout by hand
+    //a room can be left half built, generate finishes it before looking at its budget again
+    GenerationStep step();
+    //Done once the run has ended, however it ended
+    [[nodiscard]] GenerationStep getStep() const;
+    [[nodiscard]] const GenerationReport& getReport() const;
+    [[nodiscard]] const RoomList& getRooms() const;
+    //cells inside the mask no room covers yet, an upper bound on what is left for rooms still to come
+    [[nodiscard]] int getOpenCells() const;
+    [[nodiscard]] int getRoomMin() const;
+    [[nodiscard]] int getRoomMax() const;
+    [[nodiscard]] std::pmr::memory_resource* getMemory() const;
     RandomGenerator& getRandomGenerator();
+    RoomIdLayer& getRoomIds();
+    //routes a corridor for every link of graph, and writes them into the grid once placement is finished
+    //returns how many links could not be routed
+    int routeCorridors(const RoomGraph& graph);
+    CorridorList& getCorridors();
+    void setLog(GenerationLog* generationLog);
+    void setCancel(const std::atomic<bool>* cancelFlag);
+    //not owned, has to outlive generate
+    void setPlacementCheck(const PlacementCheck* placementCheck);
+    //the outline the floor is cut to, has to be set before the first generate and outlive it
+    void setBoundary(const BoundaryMask* mask);
     friend inline std::ostream& operator<<(std::ostream& os, const GeneratorImpl& data);
 };
 
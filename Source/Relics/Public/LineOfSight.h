@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+
+#include "WallGrid.h"
+
+//a sight line between two points in cells, fractional so it starts and ends where the actors stand
+struct SightQuery
+{
+    float fromR;
+    float fromC;
+    float toR;
+    float toC;
+};
+
+//answers whether the walls of a floor block sight lines, walking the cells each line crosses over the wall bits
+//queries are gathered during the frame and answered together in one parallel pass, a ticket of a batch stays
+//readable until the next batch is run, only dynamic obstacles are left for physics traces
+class LineOfSight
+{
+    static constexpr int CHUNK = 256;
+
+    const WallGrid& walls;
+    std::vector<SightQuery> pending;
+    std::vector<SightQuery> running;
+    std::vector<unsigned char> results;
+    //tickets count up across batches, pendingFirst is the first one of the batch still being gathered
+    int pendingFirst;
+    int resultsFirst;
+
+    //whether none of columns from..to of row r is a wall, a word at a time
+    [[nodiscard]] bool isRowClear(int r, int from, int to) const;
+
+public:
+    explicit LineOfSight(const WallGrid& walls);
+    //true when no wall cell lies between the two points, the cells they stand in are not counted
+    //a line through the corner between two diagonal walls is blocked, between a wall and a gap it is not
+    [[nodiscard]] bool isClear(float fromR, float fromC, float toR, float toC) const;
+    //queues a query for the next run and returns its ticket
+    int submit(const SightQuery& query);
+    //answers every query submitted since the last run, spread across the task pool
+    void run();
+    //false while the ticket's batch has not been run yet or after the next one has replaced it
+    [[nodiscard]] bool getResult(int ticket, bool& clear) const;
+    //one entry per query of the last run, 1 where the line is clear, in the order they were submitted
+    [[nodiscard]] const std::vector<unsigned char>& getResults() const;
+    [[nodiscard]] int getPendingCount() const;
+};
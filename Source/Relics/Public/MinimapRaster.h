@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "FloorPlan.h"
+
+//pixels x..x+width-1 of rows y..y+height-1, x runs along the floor's columns and y along its rows
+struct MinimapRegion
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+//the floor drawn into pixels once, off the game thread, and shown a cell at a time as it is explored
+//only the finished drawing and one bit per cell are kept, explored pixels are composed when a region is copied
+//out, so the cost follows the floor's size and never the number of rooms on it
+//pixels are 0xAARRGGBB, which is B, G, R, A in memory as PF_B8G8R8A8 expects, unexplored ones are 0
+class MinimapRaster
+{
+    static constexpr int TILE = 32;
+
+    int size;
+    int scale;
+    int dimension;
+    std::vector<uint32_t> drawing;
+    std::vector<uint64_t> explored;
+    int words;
+    //TILE x TILE pixel blocks changed since the last takeDirty
+    std::vector<unsigned char> dirtyTiles;
+    int tiles;
+
+    void fillCell(int r, int c, uint32_t colour);
+    void markDirty(int r0, int c0, int r1, int c1);
+    [[nodiscard]] bool isExplored(int r, int c) const;
+
+public:
+    static constexpr uint32_t WALL = 0xFFC8C8C8;
+    static constexpr uint32_t DOOR = 0xFFF0C040;
+    static constexpr uint32_t CORRIDOR = 0xFF606060;
+
+    //as many pixels a cell as fit in maxDimension, at least one
+    MinimapRaster(const FloorPlan& plan, int maxDimension);
+    [[nodiscard]] int getDimension() const;
+    [[nodiscard]] int getScale() const;
+    //shows cells r0..r1 and c0..c1, both inclusive and clipped to the floor, returns how many were new
+    int reveal(int r0, int c0, int r1, int c1);
+    int reveal(int r, int c);
+    //appends the regions changed since the last call, a row of tiles merged into runs, and forgets them
+    //everything is dirty to begin with so the first call uploads the whole texture
+    void takeDirty(std::vector<MinimapRegion>& regions);
+    //writes region's pixels row by row into out, pitch pixels apart
+    void copyRegion(const MinimapRegion& region, uint32_t* out, int pitch) const;
+};
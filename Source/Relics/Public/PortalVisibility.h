@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+#include "RoomGraph.h"
+
+//potentially visible rooms from a top-down view cone, clipped through the doors of the camera's room
+//angles are in radians in grid space, 0 points along +row and pi / 2 along +col
+class PortalVisibility
+{
+    struct Wedge
+    {
+        float lo;
+        float hi;
+    };
+
+    const RoomGraph& graph;
+    float maxDistance;
+    std::vector<Wedge> wedges;
+    std::vector<int> nearby;
+
+    [[nodiscard]] static Wedge extent(float r, float c, float yaw, float r0, float c0, float r1, float c1);
+    [[nodiscard]] static bool clip(const Wedge& a, const Wedge& b, Wedge& out);
+
+public:
+    PortalVisibility(const RoomGraph& graph, float maxDistance);
+    //marks visible rooms with 1 and returns the camera's room, or -1 when it stands between rooms
+    int computeVisible(float r, float c, float yaw, float halfFov, std::vector<unsigned char>& visible);
+};
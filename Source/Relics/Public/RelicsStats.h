@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+//the dungeon pipeline's timings and counters, shown in game with "stat relics"
+//and in Unreal Insights when a capture is started with -trace=default,relics (works under -nullrhi too)
+UE_TRACE_CHANNEL_EXTERN(RelicsChannel, RELICS_API)
+
+DECLARE_STATS_GROUP(TEXT("Relics"), STATGROUP_Relics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build dungeon"), STAT_RelicsBuildDungeon, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate floor"), STAT_RelicsGenerate, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build floor"), STAT_RelicsBuildFloor, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clear dungeon"), STAT_RelicsClearDungeon, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Room init"), STAT_RelicsRoomInit, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build walls"), STAT_RelicsBuildWalls, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn actor"), STAT_RelicsSpawnActor, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build corridors"), STAT_RelicsBuildCorridors, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build colliders"), STAT_RelicsBuildColliders, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build props"), STAT_RelicsBuildProps, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Rebuild navigation"), STAT_RelicsRebuildNavigation, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Portal culling"), STAT_RelicsPortalCulling, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy activity"), STAT_RelicsEnemyActivity, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Minimap"), STAT_RelicsMinimap, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Field of view"), STAT_RelicsFieldOfView, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Line of sight"), STAT_RelicsLineOfSight, STATGROUP_Relics, RELICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Room paths"), STAT_RelicsRoomPaths, STATGROUP_Relics, RELICS_API);
+
+//per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rooms spawned"), STAT_RelicsRoomsSpawned, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Instances added"), STAT_RelicsInstancesAdded, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actors spawned"), STAT_RelicsActorsSpawned, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actors destroyed"), STAT_RelicsActorsDestroyed, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Minimap regions uploaded"), STAT_RelicsMinimapRegions, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Field of view spans changed"), STAT_RelicsFieldOfViewSpans, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Line of sight queries"), STAT_RelicsLineOfSightQueries, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Room path queries"), STAT_RelicsRoomPathQueries, STATGROUP_Relics, RELICS_API);
+
+//current values
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Rooms"), STAT_RelicsRooms, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Dormant enemies"), STAT_RelicsDormantEnemies, STATGROUP_Relics, RELICS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Enemy proxies"), STAT_RelicsEnemyProxies, STATGROUP_Relics, RELICS_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsRoomsSpawned);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsInstancesAdded);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsActorsSpawned);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsActorsDestroyed);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsMinimapRegions);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsFieldOfViewSpans);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsLineOfSightQueries);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsRoomPathQueries);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsRooms);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsDormantEnemies);
+TRACE_DECLARE_INT_COUNTER_EXTERN(RelicsEnemyProxies);
+
+//times the rest of the enclosing block under both the stat and an Insights scope on the Relics channel
+#define RELICS_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Relics##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Relics##Name, RelicsChannel)
+
+#define RELICS_COUNT(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_Relics##Name, Amount); \
+	TRACE_COUNTER_ADD(Relics##Name, Amount)
+
+#define RELICS_GAUGE(Name, Value) \
+	SET_DWORD_STAT(STAT_Relics##Name, Value); \
+	TRACE_COUNTER_SET(Relics##Name, Value)
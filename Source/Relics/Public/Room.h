@@ -1,21 +1,15 @@
 #pragma once
-#include <unordered_set>
-#include <algorithm>
 #include <vector>
 
 #include "CoreMinimal.h"
+#include "EnemyCrowd.h"
+#include "FloorDelta.h"
+#include "FloorPlan.h"
 #include "RoomImpl.h"
 #include "GameFramework/Actor.h"
 #include "Relics/Utils/Utils.h"
 #include "Room.generated.h"
 
-
-struct PairHash {
-	std::size_t operator()(const std::pair<int, int>& p) const {
-		return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
-	}
-};
-
 UCLASS()
 class RELICS_API ARoom : public AActor
 {
@@ -27,26 +21,26 @@ public:
 	GENERATED_BODY()
 	
 	RoomImpl room;
-	RandomGenerator rg;
-	std::unordered_set<std::pair<int, int>, PairHash> blocked;
+	int32 index;
 
-	void build(UWorld* world);
+	void build(UWorld* world, const RoomPlan& plan, const FloorDelta& delta, bool spawnActors, EnemyCrowd* crowd);
 	AActor* spawnActor(UWorld* world, UClass* actorType, FVector* location);
+	UClass* getSpawnClass(SpawnKind kind) const;
 
 public:
 	ARoom();
 	~ARoom();
 
-	void init(const RoomImpl& roomRef, RandomGenerator& rgRef, UClass* enemyRef, UClass* chestRef, UClass* exitRef);
-	void buildWalls();
-	void buildWall(std::vector<std::pair<int, int>>& walls);
-	void buildVerticalWall(std::pair<int, int>& p1, std::pair<int, int>& p2);
-	void buildHorizontalWall(std::pair<int, int>& p1, std::pair<int, int>& p2);
-	void buildOverheads();
-	void buildWallSegment(float r, float c, float alty, float rScale,
-							 float cScale, float zScale);
-	FVector getRandomValidPosition();
-	
+	//clients leave spawning to the server and bind the replicated actors to their slots instead
+	//with a crowd given, enemies start out as its proxies and only become actors once the player comes near
+	void init(const RoomPlan& plan, int32 roomIndex, const FloorDelta& delta, UClass* enemyRef, UClass* chestRef,
+	          UClass* exitRef, bool spawnActors = true, EnemyCrowd* crowd = nullptr);
+	void bindActor(int32 slot, AActor* actor);
+	//turns a proxy back into an actor in its old slot
+	AActor* spawnEnemy(int32 slot, const FVector& location, float yaw);
+	static FTransform getSegmentTransform(const WallSegment& segment);
+	void setRoomVisible(bool visible);
+
 
 	UPROPERTY(EditAnywhere)
 	class UInstancedStaticMeshComponent* blocks;
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+
+#include "RoomIdLayer.h"
+#include "RoomImpl.h"
+
+struct RoomBounds
+{
+    int row;
+    int col;
+    int width;
+    int height;
+};
+
+//door cells in grid coordinates rather than relative to their room
+struct DoorCell
+{
+    int room;
+    int r;
+    int c;
+};
+
+//two rooms whose closest doors face each other across the gap band
+struct RoomLink
+{
+    int a;
+    int b;
+    int doorA;
+    int doorB;
+    int distance;
+};
+
+class RoomGraph
+{
+    static constexpr int BUCKET = 16;
+
+    int size;
+    std::vector<RoomBounds> bounds;
+    std::vector<DoorCell> doors;
+    std::vector<int> firstDoor;
+    std::vector<RoomLink> links;
+    std::vector<std::vector<int>> adjacency;
+    std::vector<std::vector<int>> roomBuckets;
+    int buckets;
+    RoomIdLayer roomIds;
+
+public:
+    RoomGraph();
+    void build(const RoomList& rooms, const RoomIdLayer& ids, int gap);
+    [[nodiscard]] int getRoomCount() const;
+    [[nodiscard]] const RoomBounds& getBounds(int room) const;
+    [[nodiscard]] const DoorCell* doorsBegin(int room) const;
+    [[nodiscard]] const DoorCell* doorsEnd(int room) const;
+    [[nodiscard]] const std::vector<DoorCell>& getDoors() const;
+    [[nodiscard]] const std::vector<RoomLink>& getLinks() const;
+    [[nodiscard]] const std::vector<int>& getLinksOf(int room) const;
+    [[nodiscard]] const RoomIdLayer& getRoomIds() const;
+    //the room containing a point in cells, -1 between rooms
+    [[nodiscard]] int findRoom(float r, float c) const;
+    //appends every room whose bounds come within radius cells of (r, c)
+    void roomsNear(float r, float c, float radius, std::vector<int>& out) const;
+    //door hops from room to every room, -1 when unreachable or further than maxHops
+    void hopsFrom(int room, int maxHops, std::vector<int>& hops) const;
+    //the same from whichever of rooms is closest, rooms off the graph are left out
+    void hopsFrom(const std::vector<int>& rooms, int maxHops, std::vector<int>& hops) const;
+};
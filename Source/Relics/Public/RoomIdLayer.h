@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "RoomImpl.h"
+
+//which room owns each cell, so a position can be mapped to a room without searching
+//the character grid only keeps id % 78 and wraps long before a large floor runs out of rooms
+class RoomIdLayer
+{
+    int size;
+    std::pmr::vector<uint16_t> cells;
+
+public:
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr int MAX_ROOMS = NONE;
+
+    RoomIdLayer();
+    explicit RoomIdLayer(int size, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    //marks the room's walls, doors and everything inside its outline with index
+    void stamp(const RoomImpl& room, int index);
+    //the room index at a cell, -1 for the gap band, the mask and anything off the grid
+    [[nodiscard]] int get(int r, int c) const;
+    [[nodiscard]] int getSize() const;
+    [[nodiscard]] size_t getMemoryUsage() const;
+};
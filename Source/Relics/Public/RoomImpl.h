@@ -1,9 +1,27 @@
 #pragma once
+#include <memory_resource>
+#include <set>
 #include <vector>
 
+#include "RoomStamps.h"
 #include "TwoDArray.h"
 #include "Relics/Utils/Utils.h"
 
+enum class RoomShape : unsigned char
+{
+    Box,
+    L,
+    U,
+    O,
+    T,
+    Cross,
+    Rounded
+};
+
+//cells draw from the generation's memory resource, copies made outside a run go back to the default heap
+using CellList = std::pmr::vector<std::pair<int, int>>;
+using CellSet = std::pmr::set<std::pair<int, int>>;
+
 class RoomImpl {
 
     unsigned int id;
@@ -11,27 +29,55 @@ class RoomImpl {
     unsigned int col;
     unsigned int width;
     unsigned int height;
-    std::vector<std::pair<int, int>> walls;
-    std::vector<std::pair<int, int>> interior_walls;
-    std::set<std::pair<int, int>> doors;
+    RoomShape shape;
+    CellList walls;
+    CellList interior_walls;
+    CellSet doors;
 
-    void drawLine(bool isVert, std::pair<int, int>* wall, std::pair<int, int>* next, TwoDArray& grid) const;
+    //the cell by cell path for rooms too big for a stamp
+    void drawLoop(const CellList& loop, char ch, TwoDArray& grid) const;
     void reshapeL(RandomGenerator& rg);
     void reshapeU(RandomGenerator& rg);
     void reshapeO(RandomGenerator& rg);
-    void addDoors(RandomGenerator& rg);
+    void reshapeT(RandomGenerator& rg);
+    void reshapeCross(RandomGenerator& rg);
+    void reshapeRounded(RandomGenerator& rg);
+    void setOutline(const RoomStamps::Outline& outline);
+    void addDoorsToLoop(RandomGenerator& rg, CellList& loop);
     void addDoorToWall(RandomGenerator& rg, bool isVert, std::pair<int, int> next, std::pair<int, int>* wall, bool hasDoor);
 
     public:
-    RoomImpl(int id, int row, int col, int width, int height, RandomGenerator& rg);
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    RoomImpl(int id, int row, int col, int width, int height, RandomGenerator& rg, const allocator_type& allocator = {});
+    //a plain box without doors, reshape then addDoors make it the room the constructor above would have
+    RoomImpl(int id, int row, int col, int width, int height, const allocator_type& allocator = {});
     RoomImpl();
+    RoomImpl(const RoomImpl& other) = default;
+    RoomImpl(RoomImpl&& other) = default;
+    //used by containers of rooms, which hand every room their own memory resource
+    RoomImpl(const RoomImpl& other, const allocator_type& allocator);
+    RoomImpl(RoomImpl&& other, const allocator_type& allocator);
+    RoomImpl& operator=(const RoomImpl& other) = default;
+    RoomImpl& operator=(RoomImpl&& other) = default;
+    //picks the room's shape, rooms under 3 x 3 stay boxes without drawing a number
+    void reshape(RandomGenerator& rg);
+    void addDoors(RandomGenerator& rg);
     void draw(TwoDArray& grid);
+    //walls, doors and floor as bitmasks, only for rooms RoomStamp::fits
+    [[nodiscard]] RoomStamp getStamp() const;
     unsigned int getId() const;
     unsigned int getRow() const;
     unsigned int getCol() const;
     unsigned int getWidth() const;
     unsigned int getHeight() const;
-    std::set<std::pair<int, int>>& getDoors();
-    std::vector<std::pair<int, int>>& getWalls();
-    std::vector<std::pair<int, int>>& getInteriorWalls();
+    RoomShape getShape() const;
+    CellSet& getDoors();
+    const CellSet& getDoors() const;
+    CellList& getWalls();
+    const CellList& getWalls() const;
+    CellList& getInteriorWalls();
+    const CellList& getInteriorWalls() const;
 };
+
+using RoomList = std::pmr::vector<RoomImpl>;
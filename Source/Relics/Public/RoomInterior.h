@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "RoomStamps.h"
+#include "Relics/Utils/Utils.h"
+
+//the props an interior can hold, every kind is drawn with its own instanced mesh
+enum class PropKind : unsigned char
+{
+    Crate,
+    Barrel,
+    Pillar,
+    Table,
+    Chair,
+    Rug
+};
+
+static constexpr int PROP_KIND_COUNT = 6;
+
+//r and c in cells from the room's origin, or from the floor's once FloorPlan has gathered them, yaw in degrees
+struct PropInstance
+{
+    PropKind kind;
+    int r;
+    int c;
+    float yaw;
+};
+
+//fills the free floor of one room with props by wave function collapse
+//every cell's domain is a bitset of the tiles it can still become, narrowing a neighbour is a single and,
+//and what a whole domain allows next to it is looked up a byte of the domain at a time
+class RoomInterior
+{
+public:
+    enum Tile : int
+    {
+        Floor,
+        //the room's walls and everything outside them, never picked
+        Wall,
+        Crate,
+        Barrel,
+        Pillar,
+        Table,
+        Chair,
+        Rug,
+        TILE_COUNT
+    };
+
+private:
+    static constexpr int MAX_ATTEMPTS = 4;
+
+    int height;
+    int width;
+    std::array<uint64_t, RoomStamp::MAX_SIZE> floor;
+    //floor cells next to a wall
+    std::array<uint64_t, RoomStamp::MAX_SIZE> edges;
+    //floor that has to stay clear, in front of the doors and under the spawn points
+    std::array<uint64_t, RoomStamp::MAX_SIZE> reserved;
+    std::vector<uint64_t> domains;
+    std::vector<int> open;
+    std::vector<int> stack;
+
+    void reset();
+    [[nodiscard]] bool propagate();
+    [[nodiscard]] int pickCell(RandomGenerator& rg) const;
+    void collapse(int cell, RandomGenerator& rg);
+    //chairs without a table to sit at are cleared and the rest turned towards theirs
+    void seatChairs(std::vector<PropInstance>& props) const;
+    //whether every reserved cell can still be walked to from every other one
+    [[nodiscard]] bool isConnected() const;
+    [[nodiscard]] Tile getTile(int r, int c) const;
+
+public:
+    explicit RoomInterior(const RoomStamp& stamp);
+    //keeps (r, c) as bare floor, cells off the floor are ignored
+    void reserve(int r, int c);
+    //false when no attempt left the reserved cells connected, props is left as it was then
+    bool solve(RandomGenerator& rg, std::vector<PropInstance>& props);
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "CorridorRouter.h"
+#include "RoomGraph.h"
+#include "RoomInterior.h"
+#include "WallGrid.h"
+
+//a walk between two doors that stays inside the room or corridor between them, in steps of one cell
+struct PortalEdge
+{
+    int to;
+    int cost;
+};
+
+//the floor seen from far away, every door a portal and every room or run of corridor a cluster between them
+//built once per floor with every portal's walks to the others of its clusters cached, so a long way across the floor
+//is searched over a few hundred doors instead of tens of thousands of cells
+class RoomPaths
+{
+    int size;
+    //per cell, the index of the door standing on it, or one of these
+    std::vector<int> cells;
+    std::vector<int> portals;
+    std::vector<int> firstEdge;
+    std::vector<PortalEdge> edges;
+
+public:
+    static constexpr int OPEN = -1;
+    static constexpr int BLOCKED = -2;
+
+    //what a walk out from one cell found, g and parent are only valid where seen matches stamp
+    struct Reach
+    {
+        std::vector<int> g;
+        std::vector<int> parent;
+        std::vector<unsigned> seen;
+        unsigned stamp = 0;
+        //the doors reached, in the order they were
+        std::vector<int> doors;
+        std::vector<int> queue;
+    };
+
+    RoomPaths();
+    //rooms and corridors are walked, walls and every prop but rugs are not, door indices are the graph's
+    void build(const RoomGraph& graph, const WallGrid& walls, const std::vector<Corridor>& corridors,
+               const std::array<std::vector<PropInstance>, PROP_KIND_COUNT>& props);
+    //the door at a cell, OPEN or BLOCKED otherwise, anything off the floor is BLOCKED
+    [[nodiscard]] int getCell(int r, int c) const;
+    [[nodiscard]] int getPortalCount() const;
+    //the cell of a door as r * size + c
+    [[nodiscard]] int getPortalCell(int portal) const;
+    [[nodiscard]] const PortalEdge* edgesBegin(int portal) const;
+    [[nodiscard]] const PortalEdge* edgesEnd(int portal) const;
+    //breadth first from cell over open cells, a door is reached but only walked through when the walk starts on it,
+    //so a walk never leaves the clusters around its start, it stops early once stopAt is reached unless that is -1
+    void walk(int cell, int stopAt, Reach& reach) const;
+    [[nodiscard]] int getSize() const;
+    [[nodiscard]] size_t getMemoryUsage() const;
+};
+
+//a way between two cells, the doors it passes through and the cells near both ends of it
+struct RoomPath
+{
+    //steps from start to goal
+    int length = 0;
+    //by their index in RoomGraph::getDoors, in the order they are passed through
+    std::vector<int> doors;
+    //start to the first door and the last door to goal, doors included, or start to goal when no door is passed
+    std::vector<std::pair<int, int>> head;
+    std::vector<std::pair<int, int>> tail;
+};
+
+//answers long-range path queries over RoomPaths with A*, refining to cells only where the path starts and ends
+//the buffers are reused across queries, so one instance serves every query of a floor from a single thread
+class RoomPathfinder
+{
+    struct Node
+    {
+        int f;
+        int portal;
+    };
+
+    const RoomPaths& paths;
+    RoomPaths::Reach start;
+    RoomPaths::Reach goal;
+    //the abstract search over portals, stamped like the walks
+    std::vector<int> g;
+    std::vector<int> parent;
+    std::vector<unsigned> seen;
+    std::vector<unsigned> closed;
+    std::vector<int> goalCost;
+    std::vector<unsigned> goalSeen;
+    unsigned stamp;
+    std::vector<Node> open;
+
+    //the cells from the walk's start to cell, both included
+    void trace(const RoomPaths::Reach& reach, int cell, std::vector<std::pair<int, int>>& out) const;
+
+public:
+    explicit RoomPathfinder(const RoomPaths& paths);
+    //false when either cell is blocked or nothing connects them
+    bool find(int fromR, int fromC, int toR, int toC, RoomPath& out);
+    //the cells from path.doors[hop] to path.doors[hop + 1], both included, for when an agent gets that far
+    bool refine(const RoomPath& path, int hop, std::vector<std::pair<int, int>>& out);
+};
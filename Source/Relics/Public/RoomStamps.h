@@ -0,0 +1,293 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <utility>
+
+//a room's walls and doors as one bitmask per row, bit c of a row is column c of the room
+//drawing a room is then a couple of word operations per row instead of a set lookup per cell
+struct RoomStamp
+{
+    static constexpr int MAX_SIZE = 64;
+
+    int height = 0;
+    int width = 0;
+    std::array<uint64_t, MAX_SIZE> walls{};
+    std::array<uint64_t, MAX_SIZE> doors{};
+    //cells enclosed by the walls, see RoomStamps::fillFloor
+    std::array<uint64_t, MAX_SIZE> floor{};
+
+    [[nodiscard]] static constexpr bool fits(const int height, const int width)
+    {
+        return height > 0 && width > 0 && height <= MAX_SIZE && width <= MAX_SIZE;
+    }
+};
+
+//the outlines rooms can take and the rasterizer that turns them into stamps
+//everything is constexpr, so a fixed shape can be baked into the binary and checked with static_assert
+namespace RoomStamps
+{
+    static constexpr int MAX_CORNERS = 48;
+    static constexpr int MAX_RADIUS = 4;
+
+    //corners of a closed rectilinear outline, the first edge vertical and the edges alternating from there,
+    //the way RoomImpl keeps its walls
+    struct Outline
+    {
+        int count = 0;
+        std::array<std::pair<int, int>, MAX_CORNERS> corners{};
+
+        constexpr void add(const int r, const int c)
+        {
+            corners[count++] = {r, c};
+        }
+    };
+
+    //bits from..to of a row, both inclusive
+    constexpr uint64_t span(const int from, const int to)
+    {
+        const uint64_t high = to >= 63 ? ~uint64_t(0) : (uint64_t(2) << to) - 1;
+        return high & ~((uint64_t(1) << from) - 1);
+    }
+
+    //ors the edges of a closed loop of corners into the stamp's walls
+    template <typename Iterator>
+    constexpr void trace(Iterator first, const Iterator last, RoomStamp& stamp)
+    {
+        if (first == last)
+        {
+            return;
+        }
+        const Iterator begin = first;
+        while (first != last)
+        {
+            Iterator next = first;
+            ++next;
+            const auto& a = *first;
+            const auto& b = next == last ? *begin : *next;
+            if (a.second == b.second)
+            {
+                const int from = a.first < b.first ? a.first : b.first;
+                const int to = a.first < b.first ? b.first : a.first;
+                for (int r = from; r <= to; r++)
+                {
+                    stamp.walls[r] |= uint64_t(1) << a.second;
+                }
+            }
+            else
+            {
+                stamp.walls[a.first] |= a.second < b.second ? span(a.second, b.second) : span(b.second, a.second);
+            }
+            first = next;
+        }
+    }
+
+    //toggles the cells right of every vertical edge of a closed loop, counting an edge on the rows it starts on
+    //but not on the one it ends on, so a row's toggles cross each wall exactly once
+    template <typename Iterator>
+    constexpr void crossings(Iterator first, const Iterator last, RoomStamp& stamp)
+    {
+        if (first == last)
+        {
+            return;
+        }
+        const Iterator begin = first;
+        while (first != last)
+        {
+            Iterator next = first;
+            ++next;
+            const auto& a = *first;
+            const auto& b = next == last ? *begin : *next;
+            if (a.second == b.second)
+            {
+                const int from = a.first < b.first ? a.first : b.first;
+                const int to = a.first < b.first ? b.first : a.first;
+                for (int r = from; r < to; r++)
+                {
+                    stamp.floor[r] ^= uint64_t(1) << a.second;
+                }
+            }
+            first = next;
+        }
+    }
+
+    //turns the toggles left by crossings into the cells inside an odd number of loops that are not walls,
+    //a prefix xor along each row, so a courtyard inside a second loop stays outside
+    constexpr void fillFloor(RoomStamp& stamp)
+    {
+        for (int r = 0; r < stamp.height; r++)
+        {
+            uint64_t inside = stamp.floor[r];
+            inside ^= inside << 1;
+            inside ^= inside << 2;
+            inside ^= inside << 4;
+            inside ^= inside << 8;
+            inside ^= inside << 16;
+            inside ^= inside << 32;
+            stamp.floor[r] = inside & ~stamp.walls[r] & span(0, stamp.width - 1);
+        }
+    }
+
+    constexpr RoomStamp rasterize(const Outline& outline, const int height, const int width)
+    {
+        RoomStamp stamp;
+        stamp.height = height;
+        stamp.width = width;
+        trace(outline.corners.begin(), outline.corners.begin() + outline.count, stamp);
+        crossings(outline.corners.begin(), outline.corners.begin() + outline.count, stamp);
+        fillFloor(stamp);
+        return stamp;
+    }
+
+    constexpr Outline box(const int height, const int width)
+    {
+        Outline outline;
+        outline.add(0, 0);
+        outline.add(height - 1, 0);
+        outline.add(height - 1, width - 1);
+        outline.add(0, width - 1);
+        return outline;
+    }
+
+    //a bar along the far side and a stem between columns c1 and c2 reaching down to row 0,
+    //the corners below depth are cut away
+    constexpr Outline tee(const int height, const int width, const int depth, const int c1, const int c2)
+    {
+        Outline outline;
+        outline.add(depth, 0);
+        outline.add(height - 1, 0);
+        outline.add(height - 1, width - 1);
+        outline.add(depth, width - 1);
+        outline.add(depth, c2);
+        outline.add(0, c2);
+        outline.add(0, c1);
+        outline.add(depth, c1);
+        return outline;
+    }
+
+    //a full-width bar between rows r1 and r2 crossing a full-height bar between columns c1 and c2
+    constexpr Outline cross(const int height, const int width, const int r1, const int r2, const int c1, const int c2)
+    {
+        Outline outline;
+        outline.add(r1, 0);
+        outline.add(r2, 0);
+        outline.add(r2, c1);
+        outline.add(height - 1, c1);
+        outline.add(height - 1, c2);
+        outline.add(r2, c2);
+        outline.add(r2, width - 1);
+        outline.add(r1, width - 1);
+        outline.add(r1, c2);
+        outline.add(0, c2);
+        outline.add(0, c1);
+        outline.add(r1, c1);
+        return outline;
+    }
+
+    constexpr int isqrt(const int value)
+    {
+        int root = 0;
+        while ((root + 1) * (root + 1) <= value)
+        {
+            root++;
+        }
+        return root;
+    }
+
+    //how far row i of a corner of radius r is pulled in from the side, a quarter circle in whole cells
+    constexpr std::array<std::array<int, MAX_RADIUS>, MAX_RADIUS + 1> makeInsets()
+    {
+        std::array<std::array<int, MAX_RADIUS>, MAX_RADIUS + 1> insets{};
+        for (int radius = 1; radius <= MAX_RADIUS; radius++)
+        {
+            for (int i = 0; i < radius; i++)
+            {
+                insets[radius][i] = radius - isqrt(radius * radius - (radius - i) * (radius - i));
+            }
+        }
+        return insets;
+    }
+
+    inline constexpr auto INSETS = makeInsets();
+
+    //a box whose corners are stepped in along a quarter circle, needs sides of at least 2 * radius + 2
+    constexpr Outline rounded(const int height, const int width, const int radius)
+    {
+        //the bottom left corner walked from the bottom edge up to the left edge, ending on (radius, 0)
+        Outline corner;
+        const auto& inset = INSETS[radius];
+        corner.add(0, inset[0]);
+        for (int i = 1; i <= radius; i++)
+        {
+            const int next = i < radius ? inset[i] : 0;
+            if (next != inset[i - 1])
+            {
+                corner.add(i, inset[i - 1]);
+                corner.add(i, next);
+            }
+        }
+
+        //the other three are mirrors of it, walked in the order the outline goes round
+        Outline outline;
+        outline.add(radius, 0);
+        for (int i = corner.count - 1; i >= 0; i--)
+        {
+            outline.add(height - 1 - corner.corners[i].first, corner.corners[i].second);
+        }
+        for (int i = 0; i < corner.count; i++)
+        {
+            outline.add(height - 1 - corner.corners[i].first, width - 1 - corner.corners[i].second);
+        }
+        for (int i = corner.count - 1; i >= 0; i--)
+        {
+            outline.add(corner.corners[i].first, width - 1 - corner.corners[i].second);
+        }
+        for (int i = 0; i < corner.count - 1; i++)
+        {
+            outline.add(corner.corners[i].first, corner.corners[i].second);
+        }
+        return outline;
+    }
+
+    //turns an outline drawn for the first side a quarter at a time, odd turns draw it with height and width swapped
+    //the corners are rotated so the outline still starts on a vertical edge
+    constexpr Outline turn(const Outline& outline, const int height, const int width, const int turns)
+    {
+        Outline turned;
+        for (int i = 0; i < outline.count; i++)
+        {
+            const auto [r, c] = outline.corners[i];
+            switch (turns & 3)
+            {
+            case 1:
+                turned.add(c, width - 1 - r);
+                break;
+            case 2:
+                turned.add(height - 1 - r, width - 1 - c);
+                break;
+            case 3:
+                turned.add(height - 1 - c, r);
+                break;
+            default:
+                turned.add(r, c);
+            }
+        }
+        if (turned.count > 1 && turned.corners[0].second != turned.corners[1].second)
+        {
+            Outline shifted;
+            for (int i = 0; i < turned.count; i++)
+            {
+                shifted.add(turned.corners[(i + 1) % turned.count].first, turned.corners[(i + 1) % turned.count].second);
+            }
+            return shifted;
+        }
+        return turned;
+    }
+
+    static_assert(span(0, 4) == 0b11111 && span(2, 3) == 0b1100 && span(0, 63) == ~uint64_t(0));
+    static_assert(rasterize(box(3, 4), 3, 4).walls[1] == 0b1001);
+    static_assert(rasterize(box(4, 5), 4, 5).floor[0] == 0 && rasterize(box(4, 5), 4, 5).floor[2] == 0b01110);
+    static_assert(rasterize(cross(10, 10, 3, 6, 3, 6), 10, 10).walls[0] == span(3, 6));
+    static_assert(INSETS[2][0] == 2 && INSETS[2][1] == 1 && INSETS[4][1] == 2);
+    static_assert(rasterize(rounded(10, 10, 2), 10, 10).walls[0] == span(2, 7));
+    static_assert(turn(tee(8, 11, 3, 3, 7), 11, 8, 1).corners[0].second == turn(tee(8, 11, 3, 3, 7), 11, 8, 1).corners[1].second);
+}
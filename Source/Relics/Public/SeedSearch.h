@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "BoundaryMask.h"
+#include "FloorPlan.h"
+
+//one thing a designer wants from a floor
+//canStillHold sees the layout while rooms are still being placed and holds sees the finished floor,
+//so a seed that is already lost is dropped without placing the rest of its rooms
+class SeedConstraint
+{
+public:
+    virtual ~SeedConstraint() = default;
+    //asked after every room placed, the newest is rooms.back(), false when no later room can save the layout
+    [[nodiscard]] virtual bool canStillHold([[maybe_unused]] const GeneratorImpl& layout) const
+    {
+        return true;
+    }
+    [[nodiscard]] virtual bool holds(const FloorPlan& plan) const = 0;
+};
+
+//at least count rooms
+//given up once the open cells could not fit the missing rooms even at the smallest size
+class MinRoomsConstraint : public SeedConstraint
+{
+    int count;
+
+public:
+    explicit MinRoomsConstraint(int count);
+    [[nodiscard]] bool canStillHold(const GeneratorImpl& layout) const override;
+    [[nodiscard]] bool holds(const FloorPlan& plan) const override;
+};
+
+//no room narrower than cells on either side, a room is never resized once placed
+class MinRoomSizeConstraint : public SeedConstraint
+{
+    int cells;
+
+public:
+    explicit MinRoomSizeConstraint(int cells);
+    [[nodiscard]] bool canStillHold(const GeneratorImpl& layout) const override;
+    [[nodiscard]] bool holds(const FloorPlan& plan) const override;
+};
+
+//an exit no more than doors door hops from the first room placed, where the player walks in
+//exits are only rolled once the floor is planned, so this one can only be told on the finished floor
+class ExitWithinDoorsConstraint : public SeedConstraint
+{
+    int doors;
+
+public:
+    explicit ExitWithinDoorsConstraint(int doors);
+    [[nodiscard]] bool holds(const FloorPlan& plan) const override;
+};
+
+struct SeedSearchResult
+{
+    //the lowest matching seeds of the range, in order
+    std::vector<unsigned int> seeds;
+    //seeds generated at all, and those of them a check gave up on before they were finished
+    int tried = 0;
+    int abandoned = 0;
+    bool cancelled = false;
+};
+
+//finds seeds whose floors meet every constraint, a seed per task across the shared pool
+//every worker generates on an arena of its own, and the seeds past the last match still needed are dropped
+//as soon as enough lower ones have matched, so the answer is the same however the seeds were spread
+class SeedSearch
+{
+    int size;
+    int room_min;
+    int room_max;
+    int gap;
+    std::optional<BoundaryShape> boundary;
+    std::vector<std::unique_ptr<SeedConstraint>> constraints;
+
+    [[nodiscard]] bool canStillHold(const GeneratorImpl& layout) const;
+    [[nodiscard]] bool holds(const FloorPlan& plan) const;
+
+public:
+    SeedSearch(int size, int room_min, int room_max, int gap);
+    //every seed is cut to its own outline of this shape, the circle when none is set
+    void setBoundary(BoundaryShape shape);
+    void require(std::unique_ptr<SeedConstraint> constraint);
+    //tries first, first + 1, ... up to count seeds until matches of them meet every constraint
+    SeedSearchResult find(unsigned int first, int count, int matches,
+                          const std::atomic<bool>* cancel = nullptr) const;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "RoomImpl.h"
+#include "Relics/Utils/Utils.h"
+
+enum class SpawnKind : unsigned char
+{
+    Enemy,
+    Chest,
+    Exit
+};
+
+static constexpr int SPAWN_KIND_COUNT = 3;
+
+//how many spawns of one kind a room gets and how much room they want around them
+struct SpawnBudget
+{
+    //share of the rooms that get any of the kind at all
+    float chance = 1.f;
+    //a room gets one per this many floor cells, clamped to the per room limits, 0 always gives minPerRoom
+    int cellsPerSpawn = 0;
+    int minPerRoom = 1;
+    int maxPerRoom = 1;
+    //0 leaves the floor uncapped
+    int maxPerFloor = 0;
+    //in cells, two spawns keep the larger of their kinds' spacing between them
+    float spacing = 2.f;
+};
+
+struct SpawnSettings
+{
+    std::array<SpawnBudget, SPAWN_KIND_COUNT> budgets;
+    //in cells, nothing is spawned this close to a door so doorways stay clear
+    float doorClearance = 1.5f;
+
+    //an enemy and a chest in every room, more enemies in the bigger ones, and an exit in a few
+    static SpawnSettings defaults();
+};
+
+//r and c in floor cells
+struct PlannedSpawn
+{
+    SpawnKind kind;
+    int room;
+    int r;
+    int c;
+};
+
+//plans the spawns of a whole floor in one pass, Poisson-disk style
+//every room's floor cells are drawn in a shuffled order and a cell is taken when nothing already planned,
+//in this room or the next one over, is closer than the spacing, so no cell is ever drawn twice for a kind
+//the distance checks look only at the buckets of a grid hash around the cell
+class SpawnPlanner
+{
+    SpawnSettings settings;
+    float bucketSize;
+    int buckets;
+    //entries chained per bucket, spawns and doors alike
+    std::vector<int> heads;
+    std::vector<int> links;
+    std::vector<float> rows;
+    std::vector<float> cols;
+    //a door's radius is its clearance, a spawn's the spacing of its kind
+    std::vector<float> radii;
+    std::vector<unsigned char> doors;
+    std::vector<int> candidates;
+    std::array<int, SPAWN_KIND_COUNT> planned;
+
+    [[nodiscard]] int getBucket(float r, float c) const;
+    void insert(float r, float c, float radius, bool door);
+    [[nodiscard]] bool isClear(float r, float c, float spacing) const;
+    //local floor cells a spawn may stand on, r * width + c
+    void gatherFloor(const RoomImpl& room);
+    [[nodiscard]] int countFor(SpawnKind kind, RandomGenerator& rg) const;
+
+public:
+    SpawnPlanner(int size, const SpawnSettings& settings = SpawnSettings::defaults());
+    //appends the spawns of every room to out, room by room, rooms without doors get none
+    //rooms are planned in order and only look back, so the spawns of a partial floor stay put once it grows
+    void plan(const RoomList& rooms, RandomGenerator& rg, std::vector<PlannedSpawn>& out);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//one bit per cell of a floor, set where a wall stands, doors and everything between the rooms are left clear
+//64 cells of a row to a word, so sight lines can be walked and whole spans tested a word at a time
+class WallGrid
+{
+    int size;
+    int words;
+    std::vector<uint64_t> bits;
+
+public:
+    WallGrid()
+        : size(0), words(0)
+    {
+    }
+
+    explicit WallGrid(const int size)
+        : size(size), words((size + 63) / 64), bits(static_cast<size_t>(size) * ((size + 63) / 64), 0)
+    {
+    }
+
+    //anything off the floor counts as a wall, so a line or a light never leaves it
+    [[nodiscard]] bool isWall(const int r, const int c) const
+    {
+        if (r < 0 || c < 0 || r >= size || c >= size)
+        {
+            return true;
+        }
+        return bits[static_cast<size_t>(r) * words + c / 64] >> (c % 64) & 1;
+    }
+
+    void set(const int r, const int c, const bool wall)
+    {
+        if (r < 0 || c < 0 || r >= size || c >= size)
+        {
+            return;
+        }
+        const uint64_t bit = uint64_t(1) << (c % 64);
+        uint64_t& word = bits[static_cast<size_t>(r) * words + c / 64];
+        word = wall ? word | bit : word & ~bit;
+    }
+
+    [[nodiscard]] const uint64_t* getRow(const int r) const
+    {
+        return bits.data() + static_cast<size_t>(r) * words;
+    }
+
+    [[nodiscard]] int getSize() const
+    {
+        return size;
+    }
+
+    [[nodiscard]] int getWords() const
+    {
+        return words;
+    }
+
+    [[nodiscard]] size_t getMemoryUsage() const
+    {
+        return bits.capacity() * sizeof(uint64_t);
+    }
+};
@@ -10,7 +10,7 @@ public class Relics : ModuleRules
 		
 		OptimizeCode = CodeOptimization.Never;
 	
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "NavigationSystem" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "NavigationSystem", "AIModule", "PhysicsCore" });
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
@@ -1,7 +1,10 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <functional>
 #include <random>
 #include <limits>
+#include <utility>
 
 #define unless(cond) if (!(cond))
 
@@ -14,13 +17,33 @@ public:
 		: gen(seed), seed(seed) {}
 
 	// Method to generate a random number
+	// std::uniform_int_distribution differs between standard libraries, so the range is reduced by hand
+	// to give every platform the same layout for the same seed
 	inline int getRandom(const int min = 0, const int max = std::numeric_limits<int>::max()) {
-		std::uniform_int_distribution<> distrib(min, max);
-		return distrib(gen);
+		if (max <= min) {
+			return min;
+		}
+		const uint32_t span = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1u;
+		if (span == 0) {
+			return static_cast<int>(static_cast<uint32_t>(min) + static_cast<uint32_t>(gen()));
+		}
+		// rejecting the low 2^32 % span draws leaves a multiple of span, so the modulo is unbiased
+		const uint32_t reject = (0u - span) % span;
+		uint32_t x;
+		do {
+			x = static_cast<uint32_t>(gen());
+		} while (x < reject);
+		return static_cast<int>(static_cast<uint32_t>(min) + x % span);
 	}
 
 	[[nodiscard]] unsigned int getSeed() const
 	{
 		return seed;
 	}
-};
\ No newline at end of file
+};
+
+struct PairHash {
+	std::size_t operator()(const std::pair<int, int>& p) const {
+		return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
+	}
+};
@@ -0,0 +1,102 @@
+//generates floors on a GenerationArena and counts what still reaches the global heap
+//build from the repo root:
+//  g++ -std=c++20 -O2 -pthread -ISource -ISource/Relics/Public -ISource/Relics/Private -ISource/Relics/Utils Tools/AllocCheck/AllocCheck.cpp Source/Relics/Private/GeneratorImpl.cpp Source/Relics/Private/RoomImpl.cpp Source/Relics/Private/RoomIdLayer.cpp Source/Relics/Private/RoomGraph.cpp Source/Relics/Private/CorridorRouter.cpp Source/Relics/Private/GenerationLog.cpp Source/Relics/Private/GenerationArena.cpp Source/Relics/Private/BoundaryMask.cpp -o AllocCheck
+//usage:
+//  AllocCheck [--size N] [--runs N] [--seed N]
+//once the arena has grown to fit, every run after the first should report 0 heap allocations
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "GenerationArena.h"
+#include "GeneratorImpl.h"
+
+namespace
+{
+	//plain new only, an arena spill goes through the aligned overloads and shows up in its own column
+	std::atomic<size_t> heapAllocations{0};
+}
+
+void* operator new(const size_t count)
+{
+	heapAllocations++;
+	if (void* pointer = std::malloc(count ? count : 1))
+	{
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](const size_t count)
+{
+	return operator new(count);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+int main(int argc, char** argv)
+{
+	int size = 128;
+	int runs = 8;
+	int seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!std::strcmp(argv[i], "--size"))
+		{
+			size = std::atoi(argv[i + 1]);
+		}
+		else if (!std::strcmp(argv[i], "--runs"))
+		{
+			runs = std::atoi(argv[i + 1]);
+		}
+		else if (!std::strcmp(argv[i], "--seed"))
+		{
+			seed = std::atoi(argv[i + 1]);
+		}
+	}
+
+	GenerationArena arena;
+	std::printf("%4s %6s %10s %12s %10s %8s %6s\n", "run", "rooms", "arena", "bytes", "capacity", "spills", "heap");
+	for (int run = 0; run < runs; run++)
+	{
+		arena.reset();
+		const size_t before = heapAllocations.load();
+		size_t rooms;
+		size_t served;
+		size_t used;
+		size_t spills;
+		{
+			GeneratorImpl generator(size, 4, 16, 3, seed + run, &arena);
+			generator.generate();
+			rooms = generator.getRooms().size();
+			served = arena.getAllocations();
+			used = arena.getUsedBytes();
+			spills = arena.getSpills();
+		}
+		const size_t heap = heapAllocations.load() - before;
+		std::printf("%4d %6zu %10zu %12zu %10zu %8zu %6zu\n", run, rooms, served, used, arena.getCapacity(), spills,
+		            heap);
+	}
+	return 0;
+}
@@ -0,0 +1,243 @@
+//replays a binary generation log written by GenerationLog
+//build from the repo root:
+//  g++ -std=c++20 -O2 -ISource -ISource/Relics/Public Tools/GenLogViewer/GenLogViewer.cpp Source/Relics/Private/GenerationLog.cpp -o GenLogViewer
+//usage:
+//  GenLogViewer <log.rgl> [--heat probes|time] [--width N] [--step]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "GenerationLog.h"
+
+namespace
+{
+	const char* eventNames[] = {"mask", "probe fit", "probe space", "place", "reshape", "door", "retry", "end"};
+	const char* shapeNames[] = {"box", "L", "U", "O", "T", "cross", "rounded"};
+	const char ramp[] = " .:-=+*#%@";
+
+	struct Placement
+	{
+		GenerationRecord record;
+		uint64_t nanos;
+		uint64_t probes;
+		int retries;
+	};
+
+	void printHeat(const std::vector<double>& heat, const int size, const int width)
+	{
+		const int step = std::max(1, (size + width - 1) / width);
+		const int cells = (size + step - 1) / step;
+		std::vector<double> binned(static_cast<size_t>(cells) * cells, 0.0);
+		for (int r = 0; r < size; r++)
+		{
+			for (int c = 0; c < size; c++)
+			{
+				binned[(r / step) * cells + c / step] += heat[r * size + c];
+			}
+		}
+		const double max = *std::max_element(binned.begin(), binned.end());
+
+		//row 0 is printed last so the picture matches TwoDArray's output
+		for (int r = cells - 1; r >= 0; r--)
+		{
+			std::string line;
+			for (int c = 0; c < cells; c++)
+			{
+				const double v = binned[r * cells + c];
+				const int index = max > 0 ? static_cast<int>(v / max * (sizeof(ramp) - 2) + 0.999) : 0;
+				line += ramp[std::min(index, static_cast<int>(sizeof(ramp) - 2))];
+			}
+			std::cout << line << '\n';
+		}
+		std::cout << "scale: 1 char = " << step << "x" << step << " cells, '@' = " << max << std::endl;
+	}
+
+	void printLayout(const std::vector<Placement>& placed, const std::vector<GenerationRecord>& doors, const int size,
+	                 const int width)
+	{
+		const int step = std::max(1, (size + width - 1) / width);
+		const int cells = (size + step - 1) / step;
+		std::vector<char> layout(static_cast<size_t>(cells) * cells, '-');
+		for (const auto& p : placed)
+		{
+			const char ch = static_cast<char>(p.record.id % (126 - 48) + 48);
+			for (int r = p.record.row; r < p.record.row + p.record.height; r++)
+			{
+				for (int c = p.record.col; c < p.record.col + p.record.width; c++)
+				{
+					layout[(r / step) * cells + c / step] = ch;
+				}
+			}
+		}
+		for (const auto& d : doors)
+		{
+			if (d.row >= 0 && d.row < size && d.col >= 0 && d.col < size)
+			{
+				layout[(d.row / step) * cells + d.col / step] = ' ';
+			}
+		}
+		for (int r = cells - 1; r >= 0; r--)
+		{
+			std::cout.write(&layout[r * cells], cells);
+			std::cout << '\n';
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <log.rgl> [--heat probes|time] [--width N] [--step]" << std::endl;
+		return 1;
+	}
+
+	bool step = false;
+	bool heatTime = false;
+	int width = 120;
+	for (int i = 2; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--step"))
+		{
+			step = true;
+		}
+		else if (!std::strcmp(argv[i], "--heat") && i + 1 < argc)
+		{
+			heatTime = !std::strcmp(argv[++i], "time");
+		}
+		else if (!std::strcmp(argv[i], "--width") && i + 1 < argc)
+		{
+			width = std::max(8, std::atoi(argv[++i]));
+		}
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	GenerationLogReader reader(bytes);
+	if (!reader.valid() || reader.size <= 0)
+	{
+		std::cerr << argv[1] << " is not a generation log" << std::endl;
+		return 1;
+	}
+
+	const int size = reader.size;
+	std::cout << "seed: " << reader.seed << " size: " << size << " room: " << reader.room_min << "-"
+		<< reader.room_max << " gap: " << reader.gap << std::endl;
+
+	const size_t eventCount = static_cast<size_t>(GenerationEvent::Count);
+	std::vector<uint64_t> counts(eventCount, 0);
+	std::vector<uint64_t> nanos(eventCount, 0);
+	std::vector<double> heat(static_cast<size_t>(size) * size, 0.0);
+	std::vector<Placement> placed;
+	std::vector<GenerationRecord> doors;
+
+	uint64_t sinceLastPlace = 0;
+	uint64_t probesSinceLastPlace = 0;
+	int retriesSinceLastPlace = 0;
+	int result = -1;
+	//a probe is logged before its cell is tested, so the time up to the next event is that cell's
+	int testing = -1;
+
+	GenerationRecord record{};
+	while (reader.next(record))
+	{
+		const auto type = static_cast<size_t>(record.type);
+		counts[type]++;
+		nanos[type] += record.nanos;
+		sinceLastPlace += record.nanos;
+		if (heatTime && testing >= 0)
+		{
+			heat[testing] += static_cast<double>(record.nanos);
+		}
+		testing = -1;
+
+		switch (record.type)
+		{
+		case GenerationEvent::ProbeFit:
+		case GenerationEvent::ProbeSpace:
+			probesSinceLastPlace++;
+			if (record.row >= 0 && record.row < size && record.col >= 0 && record.col < size)
+			{
+				testing = record.row * size + record.col;
+				if (!heatTime)
+				{
+					heat[testing] += 1.0;
+				}
+			}
+			break;
+		case GenerationEvent::Place:
+			placed.push_back({record, sinceLastPlace, probesSinceLastPlace, retriesSinceLastPlace});
+			sinceLastPlace = 0;
+			probesSinceLastPlace = 0;
+			retriesSinceLastPlace = 0;
+			break;
+		case GenerationEvent::Reshape:
+			if (step && !placed.empty())
+			{
+				const auto& p = placed.back();
+				std::cout << "\nroom " << p.record.id << " at " << p.record.row << "," << p.record.col << " "
+					<< p.record.width << "x" << p.record.height << " shape "
+					<< shapeNames[std::min(record.value, 6)] << " after " << p.probes << " probes, " << p.retries
+					<< " retries, " << p.nanos / 1000.0 << " us\n";
+			}
+			break;
+		case GenerationEvent::Door:
+			doors.push_back(record);
+			break;
+		case GenerationEvent::Retry:
+			retriesSinceLastPlace++;
+			break;
+		case GenerationEvent::End:
+			result = record.value;
+			break;
+		default:
+			break;
+		}
+
+		if (step && record.type == GenerationEvent::Reshape)
+		{
+			printLayout(placed, doors, size, width);
+			std::cout << "[enter] next, [q] quit replay" << std::flush;
+			std::string line;
+			if (!std::getline(std::cin, line) || (!line.empty() && line[0] == 'q'))
+			{
+				step = false;
+			}
+		}
+	}
+
+	uint64_t total = 0;
+	for (const auto n : nanos)
+	{
+		total += n;
+	}
+
+	std::cout << "\nevents:\n";
+	for (size_t i = 0; i < eventCount; i++)
+	{
+		std::printf("  %-12s %10llu  %10.3f ms  %5.1f%%\n", eventNames[i], static_cast<unsigned long long>(counts[i]),
+		            nanos[i] / 1e6, total ? 100.0 * nanos[i] / total : 0.0);
+	}
+	std::printf("  total %.3f ms, %zu rooms, %zu doors, result %s\n", total / 1e6, placed.size(), doors.size(),
+	            result < 0 ? "truncated" : result ? "complete" : "gave up");
+
+	std::vector<Placement> slowest = placed;
+	std::sort(slowest.begin(), slowest.end(), [](const Placement& a, const Placement& b) { return a.nanos > b.nanos; });
+	slowest.resize(std::min<size_t>(slowest.size(), 10));
+	std::cout << "\nslowest placements:\n";
+	for (const auto& p : slowest)
+	{
+		std::printf("  room %4d  %10.3f ms  %8llu probes  %d retries\n", p.record.id, p.nanos / 1e6,
+		            static_cast<unsigned long long>(p.probes), p.retries);
+	}
+
+	std::cout << "\n" << (heatTime ? "probe time" : "probe count") << " per cell:\n";
+	printHeat(heat, size, width);
+	return 0;
+}